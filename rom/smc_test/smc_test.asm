@@ -0,0 +1,34 @@
+; self-modifying code test. the instructions are written after the cpu
+; executed or decoded them. the result is checked in the registers when
+; the execution reaches `done`
+		.org 100h
+
+		di
+		lxi sp, 8000h
+
+		; writes the operand of the instruction ahead in the same block
+		mvi a, 05h
+		sta patch_operand + 1
+patch_operand:
+		mvi b, 00h			; runs as mvi b, 05h
+
+		; writes the routine executed before
+		mvi d, 00h
+		mvi e, 00h
+		call sub
+		mvi a, 1Ch			; inr e
+		sta sub
+		call sub			; runs inr e
+
+		; writes the opcode of the instruction ahead in the same block
+		mvi a, 3Ch			; inr a
+		sta patch_opcode
+patch_opcode:
+		nop					; runs as inr a
+done:
+		jmp done
+
+		.org 140h
+sub:
+		inr d
+		ret
@@ -1,21 +1,29 @@
 #include "core/audio.h"
 #include <algorithm>
+#include <thread>
+#include <numbers>
+#include <cmath>
 #include "utils/utils.h"
 
 dev::Audio::Audio(TimerI8253& _timer, AYWrapper& _aywrapper) :
 	m_timer(_timer), m_aywrapper(_aywrapper)
 {
+	InitKernel();
+	ResetResampler();
 	Init();
 }
 
 dev::Audio::~Audio()
 {
 	Pause(true);
+#ifndef DEV_HEADLESS
 	SDL_DestroyAudioStream(m_stream);
+#endif
 }
 
 void dev::Audio::Pause(bool _pause)
 {
+#ifndef DEV_HEADLESS
 	if (_pause)
 	{
 		SDL_PauseAudioDevice(m_audioDevice);
@@ -23,10 +31,36 @@ void dev::Audio::Pause(bool _pause)
 	else {
 		SDL_ResumeAudioDevice(m_audioDevice);
 	}
+#endif
 }
 
 void dev::Audio::Mute(const bool _mute) { m_muteMul = _mute ? 0.0f : 1.0f; }
 
+// the fast-forward emulation runs faster than the playback. its samples are dropped.
+// Hardware thread
+void dev::Audio::SetFastForward(const bool _fastForward)
+{
+	if (m_fastForward == _fastForward) return;
+
+	// the partial block is dropped to not mix the samples of both modes
+	DropBlock();
+
+	if (!_fastForward)
+	{
+		// the playback resumes with the silence of the target buffering
+		// to not let the resample rate adjust to the emptied buffer
+		uint64_t writeBuffIdx = m_writeBuffIdx;
+		for (int i = 0; i < TARGET_BUFFERING; i++) {
+			m_buffer[(writeBuffIdx + i) % BUFFER_SIZE] = 0.0f;
+		}
+		m_readBuffIdx = writeBuffIdx;
+		m_writeBuffIdx = writeBuffIdx + TARGET_BUFFERING;
+		m_lastSample = 0.0f;
+	}
+
+	m_fastForward = _fastForward;
+}
+
 void dev::Audio::Reset()
 {
 	m_aywrapper.Reset();
@@ -34,11 +68,17 @@ void dev::Audio::Reset()
 	m_buffer.fill(0);
 	m_lastSample = m_readBuffIdx = m_writeBuffIdx = 0;
 	m_muteMul = 1.0f;
+	ResetResampler();
 }
 
 void dev::Audio::Init()
 {
-	const SDL_AudioSpec spec = { SDL_AUDIO_F32, 1, 50000 };
+#ifdef DEV_HEADLESS
+	// no output device. the timer and the AY are clocked with no output
+	// because the cpu reads their state back
+	m_noOutput = true;
+#else
+	const SDL_AudioSpec spec = { SDL_AUDIO_F32, 1, m_outputRate };
 
 	SDL_Init(SDL_INIT_AUDIO);
 
@@ -59,48 +99,186 @@ void dev::Audio::Init()
 	SDL_ResumeAudioDevice(m_audioDevice);
 
 	m_inited = true;
+	m_noOutput = false;
+#endif
+}
+
+// the emulation paced by the audio produces the frames as fast as the playback consumes them.
+// the resample rate stays nominal
+void dev::Audio::SetAudioPacing(const bool _audioPacing)
+{
+	m_audioPacing = _audioPacing;
+	if (m_audioPacing) m_downsampleRate = GetDownsampleRateNominal();
+}
+
+// _outputRate is 44100 or 48000. the stream converts it to the device rate.
+// Hardware thread
+void dev::Audio::SetOutputRate(const int _outputRate)
+{
+	if (m_outputRate == _outputRate) return;
+
+	m_outputRate = _outputRate;
+	m_downsampleRate = GetDownsampleRateNominal();
+#ifndef DEV_HEADLESS
+	if (m_stream)
+	{
+		const SDL_AudioSpec spec = { SDL_AUDIO_F32, 1, m_outputRate };
+		SDL_SetAudioStreamFormat(m_stream, &spec, nullptr);
+	}
+#endif
+}
+
+// waits until the playback consumes the buffered samples down to the pacing level.
+// returns false if there is no playback or it does not consume the samples.
+// a stalled playback returns false at once until it consumes the samples again.
+// Hardware thread
+bool dev::Audio::WaitBuffering()
+{
+#ifdef DEV_HEADLESS
+	return false;
+#else
+	if (!m_inited || !m_stream) return false;
+
+	uint64_t readBuffIdx = m_readBuffIdx;
+	if (m_playbackStalled)
+	{
+		if (readBuffIdx == m_stalledReadBuffIdx) return false;
+		m_playbackStalled = false;
+	}
+
+	auto timeout = std::chrono::steady_clock::now() + PACING_TIMEOUT;
+	while ((int64_t)(m_writeBuffIdx - m_readBuffIdx) > PACING_BUFFERING)
+	{
+		if (std::chrono::steady_clock::now() > timeout)
+		{
+			m_playbackStalled = true;
+			m_stalledReadBuffIdx = m_readBuffIdx;
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+#endif
 }
 
 // _cycles are ticks of the 1.5 Mhz timer.
 // Hardware thread
 void dev::Audio::Clock(int _cycles, const float _beeper)
 {
-	if (!m_inited) return;
-
 	//covox = covox - 255;
 
+	// the ay output is rendered into the block before it gets resampled
+	m_aywrapper.Clock(_cycles * 2);
+
+	if (m_fastForward || m_noOutput)
+	{
+		// the cpu reads the timer back. the ay is advanced to keep its state exact
+		// and to apply its pending writes
+		for (int tick = 0; tick < _cycles; ++tick)
+		{
+			m_timer.Clock(1);
+			if (++m_inputLen == BLOCK_LEN) DropBlock();
+		}
+		return;
+	}
+
 	for (int tick = 0; tick < _cycles; ++tick)
 	{
-		float sample = (m_timer.Clock(1) + m_aywrapper.Clock(2) + _beeper) * m_muteMul;
+		m_input[m_inputLen++] = m_timer.Clock(1) + _beeper;
+		if (m_inputLen == BLOCK_LEN) ResampleBlock();
+	}
+}
 
-		if (Downsample(sample))
+// advances the ay over the block samples without the output
+void dev::Audio::DropBlock()
+{
+	m_aywrapper.Render(nullptr, m_inputLen);
+	m_inputLen = 0;
+}
+
+// the band-limited impulses placed at KERNEL_PHASES sub-sample positions.
+// the Blackman windowed sinc. every impulse sums up to 1
+void dev::Audio::InitKernel()
+{
+	constexpr double pi = std::numbers::pi;
+
+	for (int phase = 0; phase < KERNEL_PHASES; phase++)
+	{
+		auto& impulse = m_kernel[phase];
+		double offset = double(phase) / KERNEL_PHASES;
+		double sum = 0.0;
+
+		for (int i = 0; i < KERNEL_LEN; i++)
 		{
-			m_buffer[(m_writeBuffIdx++) % BUFFER_SIZE] = sample;
-			m_lastSample = sample;
+			// the distance to the impulse center in the output samples
+			double x = i - (KERNEL_LEN / 2 - 1) - offset;
+			double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * pi * KERNEL_CUTOFF * x) / (2.0 * pi * KERNEL_CUTOFF * x);
+			double window = 0.42 + 0.5 * std::cos(2.0 * pi * x / KERNEL_LEN) + 0.08 * std::cos(4.0 * pi * x / KERNEL_LEN);
+			impulse[i] = float(sinc * window);
+			sum += impulse[i];
 		}
+
+		for (auto& val : impulse) val = float(val / sum);
 	}
 }
 
+void dev::Audio::ResetResampler()
+{
+	m_inputLen = 0;
+	m_inputLevel = 0.0f;
+	m_deltas.fill(0.0f);
+	m_deltasPos = 0.0;
+	m_outputLevel = 0.0;
+}
 
-// resamples to a lower rate using a linear interpolation.
-// returns true if the output sample is ready, false otherwise
-bool dev::Audio::Downsample(float& _sample)
+// adds a band-limited step for every change of the input level, then stores
+// the output samples no later steps can reach
+void dev::Audio::ResampleBlock()
 {
-	static int sampleCounter = 0;
-	static float accumulator = 0;
-	accumulator += _sample;
+	m_aywrapper.Render(m_input.data(), m_inputLen);
+
+	float muteMul = m_muteMul;
+	double step = 1.0 / m_downsampleRate.load(std::memory_order_relaxed);
+	double pos = m_deltasPos;
 
-	if (++sampleCounter > m_downsampleRate)
+	for (int i = 0; i < m_inputLen; i++, pos += step)
 	{
-		_sample = accumulator / m_downsampleRate;
-		sampleCounter = 0;
-		accumulator = 0;
-		return true;
+		float level = m_input[i] * muteMul;
+		float delta = level - m_inputLevel;
+		if (delta == 0.0f) continue;
+		m_inputLevel = level;
+
+		int deltaIdx = int(pos);
+		const auto& impulse = m_kernel[int((pos - deltaIdx) * KERNEL_PHASES)];
+		float* deltasP = m_deltas.data() + deltaIdx;
+
+		for (int k = 0; k < KERNEL_LEN; k++) {
+			deltasP[k] += delta * impulse[k];
+		}
 	}
+	m_inputLen = 0;
 
-	return false;
+	int outputLen = int(pos);
+	for (int i = 0; i < outputLen; i++)
+	{
+		m_outputLevel += m_deltas[i];
+		float sample = float(m_outputLevel);
+		m_buffer[(m_writeBuffIdx++) % BUFFER_SIZE] = sample;
+		m_lastSample = sample;
+	}
+
+	// the steps of the samples left
+	std::copy(m_deltas.begin() + outputLen, m_deltas.begin() + outputLen + KERNEL_LEN, m_deltas.begin());
+	std::fill(m_deltas.begin() + KERNEL_LEN, m_deltas.end(), 0.0f);
+	m_deltasPos = pos - outputLen;
+
+	// the settled output drops the rounding errors summed up by the steps
+	if (std::all_of(m_deltas.begin(), m_deltas.begin() + KERNEL_LEN, [](float _delta) { return _delta == 0.0f; })) {
+		m_outputLevel = m_inputLevel;
+	}
 }
 
+#ifndef DEV_HEADLESS
 // feeds the SDL3 playback buffer.
 void dev::Audio::Callback(void* _userdata, SDL_AudioStream* _stream, int _additionalAmount, int _totalAmount)
 {
@@ -122,15 +300,26 @@ void dev::Audio::Callback(void* _userdata, SDL_AudioStream* _stream, int _additi
 	bool underBuferring = buffering < LOW_BUFFERING;
 	bool overBuferring = buffering > HIGH_BUFFERING;
 
-	if (underBuferring)
+	// the resample rate follows the buffering smoothly
+	if (!audioP->m_audioPacing && !audioP->m_fastForward)
+	{
+		audioP->m_bufferingAvg += (buffering - audioP->m_bufferingAvg) * BUFFERING_SMOOTH;
+		double error = (audioP->m_bufferingAvg - TARGET_BUFFERING) / TARGET_BUFFERING;
+		audioP->m_rateIntegral = std::clamp(audioP->m_rateIntegral + error * RATE_KI, -RATE_ADJUST_MAX, RATE_ADJUST_MAX);
+		double adjust = std::clamp(error * RATE_KP + audioP->m_rateIntegral, -RATE_ADJUST_MAX, RATE_ADJUST_MAX);
+		audioP->m_downsampleRate = audioP->GetDownsampleRateNominal() * (1.0 + adjust);
+	}
+
+	if (audioP->m_fastForward)
+	{
+		// no samples are stored while fast-forwarding
+		std::fill(fstream, fstream + fstreamLen, 0.0f);
+	}
+	else if (underBuferring)
 	{
 		// fill in with the lastSample when it's low buffering
 		auto lastSample = audioP->m_lastSample.load();
 		std::fill(fstream, fstream + fstreamLen, lastSample);
-
-		// adjust the resample rate
-		int downsampleRate = --audioP->m_downsampleRate;
-		//dev::Log("SDL buffering is too low: {}. Sample rate is adjusted: {}", buffering, downsampleRate);
 	}
 	else
 	{
@@ -140,12 +329,10 @@ void dev::Audio::Callback(void* _userdata, SDL_AudioStream* _stream, int _additi
 			fstream[i] = audioP->m_buffer[(audioP->m_readBuffIdx++) % BUFFER_SIZE];
 		}
 
+		// drop the samples when it's high buffering
 		if (overBuferring)
 		{
 			audioP->m_readBuffIdx += fstreamLen;
-			// adjust the resample rate			
-			int downsampleRate = ++audioP->m_downsampleRate;
-			//dev::Log("SDL buffering is too big: {}. Sample rate is adjusted: {}", buffering, downsampleRate);
 		}
 	}
 
@@ -153,3 +340,4 @@ void dev::Audio::Callback(void* _userdata, SDL_AudioStream* _stream, int _additi
 	SDL_PutAudioStreamData(_stream, data, _additionalAmount);
 	SDL_stack_free(data);
 }
+#endif
@@ -2,9 +2,12 @@
 
 #include <atomic>
 #include <array>
+#include <chrono>
 #include "core/timer_i8253.h"
 #include "core/sound_ay8910.h"
+#ifndef DEV_HEADLESS
 #include "SDL3/SDL.h"
+#endif
 
 namespace dev
 {
@@ -12,8 +15,7 @@ namespace dev
     {
     private:
         static constexpr int INPUT_RATE = 1500000; // 1.5 MHz timer
-        static constexpr int OUTPUT_RATE = 50000; // 50 KHz
-        static constexpr int DOWNSAMPLE_RATE = INPUT_RATE / OUTPUT_RATE;
+        static constexpr int OUTPUT_RATE = 48000; // the buffers are sized for it
         static constexpr int CALLBACKS_PER_SEC = 100; // arbitrary number found while examining the SDL3 callback calls
         static constexpr int SDL_BUFFER = OUTPUT_RATE / CALLBACKS_PER_SEC; // the estimated SDL stream buff len
         static constexpr int SDL_BUFFERS = 8; // to make sure there is enough available data for audio streaming
@@ -21,11 +23,31 @@ namespace dev
         static constexpr int TARGET_BUFFERING = SDL_BUFFER * 4;
         static constexpr int LOW_BUFFERING = TARGET_BUFFERING - SDL_BUFFER * 2;
         static constexpr int HIGH_BUFFERING = TARGET_BUFFERING + SDL_BUFFER * 2;        
+        static constexpr int FRAME_SAMPLES = OUTPUT_RATE / 50; // the samples of an emulated frame
+        // the emulation paced by the audio waits until the buffering drops below this level
+        static constexpr int PACING_BUFFERING = TARGET_BUFFERING - FRAME_SAMPLES / 2;
+        static constexpr auto PACING_TIMEOUT = std::chrono::milliseconds(100);
+        // the resample rate controller. it runs every callback on the smoothed buffering.
+        // the adjustment is relative to the nominal downsample rate
+        static constexpr double BUFFERING_SMOOTH = 0.05; // the emulated frames fill the buffer in bursts
+        static constexpr double RATE_KP = 0.02;
+        static constexpr double RATE_KI = 0.0002;
+        static constexpr double RATE_ADJUST_MAX = 0.02;
+
+        // the band-limited resampler. every change of the input level adds a band-limited step
+        // to the output. the steps are the running sums of the band-limited impulses of the kernel
+        static constexpr int BLOCK_LEN = 1024;		// the input samples resampled at once
+        static constexpr int KERNEL_LEN = 16;		// the output samples a step spreads over
+        static constexpr int KERNEL_PHASES = 256;	// the sub-sample positions of a step
+        static constexpr double KERNEL_CUTOFF = 0.45; // relative to the output rate
+        static constexpr int DELTAS_LEN = BLOCK_LEN / 16 + KERNEL_LEN; // fits the output rates up to 90 KHz
 
         TimerI8253& m_timer;
         AYWrapper& m_aywrapper;
+#ifndef DEV_HEADLESS
         SDL_AudioDeviceID m_audioDevice = 0;
         SDL_AudioStream* m_stream = nullptr;
+#endif
         float m_muteMul = 1.0f;
 
         std::array<float, BUFFER_SIZE> m_buffer; // Audio system writes to it, SDL reads from it
@@ -33,10 +55,33 @@ namespace dev
         std::atomic_uint64_t m_writeBuffIdx = 0; // the last sample stored by the Audio system
         std::atomic<float> m_lastSample = 0.0f;
 
-        std::atomic_bool m_inited = false;
-        std::atomic_int m_downsampleRate = DOWNSAMPLE_RATE;
+        std::atomic_bool m_inited = false; // the playback device is opened
+        bool m_noOutput = true; // no samples are stored, there is no playback to read them. Hardware thread
+        std::atomic_bool m_fastForward = false; // the output is dropped, the playback is silent
+        std::atomic_int m_outputRate = OUTPUT_RATE;
+        std::atomic<double> m_downsampleRate = double(INPUT_RATE) / OUTPUT_RATE; // input ticks per output sample
+        double m_bufferingAvg = TARGET_BUFFERING; // SDL thread
+        double m_rateIntegral = 0.0; // SDL thread
+        std::atomic_bool m_audioPacing = false; // the emulation follows the playback, the rate is not adjusted
+        // the playback stopped consuming the samples at this read idx. the pacing
+        // does not wait for it until the idx moves. Hardware thread
+        bool m_playbackStalled = false;
+        uint64_t m_stalledReadBuffIdx = 0;
+
+        // the resampler state. Hardware thread
+        std::array<float, BLOCK_LEN> m_input;
+        int m_inputLen = 0;
+        float m_inputLevel = 0.0f; // the input level after the last step
+        std::array<std::array<float, KERNEL_LEN>, KERNEL_PHASES> m_kernel;
+        std::array<float, DELTAS_LEN> m_deltas; // the steps of the output samples not stored yet
+        double m_deltasPos = 0.0; // the position of the next input sample in m_deltas
+        double m_outputLevel = 0.0; // the running sum of the stored output samples
 
-        bool Downsample(float& _sample);
+        void InitKernel();
+        void ResampleBlock();
+        void DropBlock();
+        void ResetResampler();
+        auto GetDownsampleRateNominal() const -> double { return double(INPUT_RATE) / m_outputRate; };
 
     public:
         Audio(TimerI8253& _timer, AYWrapper& _aywrapper);
@@ -44,7 +89,14 @@ namespace dev
         void Init();
         void Pause(bool _pause);
         void Mute(const bool _mute);
+        void SetFastForward(const bool _fastForward);
+        void SetAudioPacing(const bool _audioPacing);
+        void SetOutputRate(const int _outputRate);
+        auto GetOutputRate() const -> int { return m_outputRate; };
+        bool WaitBuffering();
+#ifndef DEV_HEADLESS
         static void Callback(void* _userdata, SDL_AudioStream* _stream, int _additionalAmount, int _totalAmount);
+#endif
         void Clock(int _cycles, const float _beeper);
         void Reset();
     };
@@ -1,69 +1,81 @@
 #include "cpu_i8080.h"
+#include "core/hardware_bus.h"
 #include "utils/utils.h"
 
-// a number of clock cycles one machine cycle takes
-static constexpr uint64_t MACHINE_CC = 4; 
 // machine_cycle index indicating the instruction executon is over
 static constexpr uint8_t FIRST_MACHINE_CICLE_IDX = 0; 
 static constexpr uint16_t PSW_INIT = 0b00000010;
 static constexpr uint16_t PSW_NUL_FLAGS = ~0b00101000;
 
+// the flag bits of the F register
+static constexpr uint8_t FLAG_C = 1 << 0;
+static constexpr uint8_t FLAG_P = 1 << 2;
+static constexpr uint8_t FLAG_AC = 1 << 4;
+static constexpr uint8_t FLAG_Z = 1 << 6;
+static constexpr uint8_t FLAG_S = 1 << 7;
+// the unused bits 1, 3, 5 are never changed by the alu
+static constexpr uint8_t FLAGS_UNUSED = 0b00101010;
+
+
+#define CC			m_live.cc
+#define PC			m_live.pc.word
+#define PCH         m_live.pc.h
+#define PCL         m_live.pc.l
+#define SP			m_live.sp.word
+#define SPP         m_live.sp
+#define SPH         m_live.sp.h
+#define SPL         m_live.sp.l
+#define IR			m_live.ir
+#define TMP			m_live.tmp
+#define ACT			m_live.act
+#define W			m_live.wz.h
+#define Z			m_live.wz.l
+#define WZ          m_live.wz.word
+
+#define A			m_live.psw.h
+#define F			m_live.psw.l
+#define PSW			m_live.psw.word
+#define BC			m_live.bc.word
+#define BCP         m_live.bc
+#define DE			m_live.de.word
+#define DEP         m_live.de
+#define HL			m_live.hl.word
+#define HLP         m_live.hl
+#define B			m_live.bc.h
+#define C			m_live.bc.l
+#define D			m_live.de.h
+#define E			m_live.de.l
+#define H			m_live.hl.h
+#define L			m_live.hl.l
+
+#define FC			((F & FLAG_C) != 0)
+#define FP			((F & FLAG_P) != 0)
+#define FAC			((F & FLAG_AC) != 0)
+#define FZ			((F & FLAG_Z) != 0)
+#define FS			((F & FLAG_S) != 0)
+#define SET_FC(_val) F = (uint8_t)((F & ~FLAG_C) | ((_val) ? FLAG_C : 0))
+
+#define INTE		m_live.inte
+#define IFF			m_live.iff
+#define HLTA		m_live.hlta
+#define EI_PENDING	m_live.eiPending
+#define MC			m_live.mc
+
+
+dev::CpuI8080::CpuI8080()
+{
+	Init();
+}
 
-#define CC			state.cc
-#define PC			state.regs.pc.word
-#define PCH         state.regs.pc.h
-#define PCL         state.regs.pc.l
-#define SP			state.regs.sp.word
-#define SPP         state.regs.sp
-#define SPH         state.regs.sp.h
-#define SPL         state.regs.sp.l
-#define IR			state.regs.ir
-#define TMP			state.regs.tmp
-#define ACT			state.regs.act
-#define W			state.regs.wz.h
-#define Z			state.regs.wz.l
-#define WZ          state.regs.wz.word
-
-#define A			state.regs.psw.af.h
-#define F			state.regs.psw.af.l
-#define PSW			state.regs.psw.af.word
-#define BC			state.regs.bc.word
-#define BCP         state.regs.bc
-#define DE			state.regs.de.word
-#define DEP         state.regs.de
-#define HL			state.regs.hl.word
-#define HLP         state.regs.hl
-#define B			state.regs.bc.h
-#define C			state.regs.bc.l
-#define D			state.regs.de.h
-#define E			state.regs.de.l
-#define H			state.regs.hl.h
-#define L			state.regs.hl.l
-
-#define FC			state.regs.psw.c
-#define FP			state.regs.psw.p
-#define FAC			state.regs.psw.ac
-#define FZ			state.regs.psw.z
-#define FS			state.regs.psw.s
-
-#define INTS		state.ints.data
-#define INTE		state.ints.inte
-#define IFF			state.ints.iff
-#define HLTA		state.ints.hlta
-#define EI_PENDING	state.ints.eiPending
-#define MC			state.ints.mc
-
-
-dev::CpuI8080::CpuI8080(
-	Memory& _memory,
-	InputFunc _input, 
-	OutputFunc _output)
+template <class Bus>
+dev::CpuI8080Bound<Bus>::CpuI8080Bound(const Bus& _bus)
 	:
-	m_memory(_memory),
-	Input(_input),
-	Output(_output)
+	CpuI8080(),
+	m_bus(_bus),
+	m_blocks(BLOCK_CACHE_LEN)
 {
-	Init();
+	m_block = &m_blocks[0];
+	InitPredecoded<true>();
 }
 
 void dev::CpuI8080::Init()
@@ -76,11 +88,14 @@ void dev::CpuI8080::Init()
 
 void dev::CpuI8080::Reset()
 {
-	CC = PC = SP = WZ = INTS = IR = ACT = TMP = 0;
+	CC = PC = SP = WZ = IR = ACT = TMP = 0;
+	MC = 0;
+	INTE = IFF = HLTA = EI_PENDING = false;
 	F = PSW_INIT;
 }
 
-void dev::CpuI8080::ExecuteMachineCycle(bool _irq)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecuteMachineCycle(bool _irq)
 {
 	IFF |= _irq & INTE;
 
@@ -106,6 +121,309 @@ void dev::CpuI8080::ExecuteMachineCycle(bool _irq)
 	CC += MACHINE_CC;
 }
 
+// executes the whole instruction. the machine cycle funcs are called on every
+// machine cycle boundary in the same order as ExecuteMachineCycle is clocked
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecuteInstruction()
+{
+	if (m_memoryDebug) {
+		ExecuteInstr<true>();
+	}
+	else {
+		ExecuteInstr<false>();
+	}
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecuteInstr()
+{
+	if (MC != FIRST_MACHINE_CICLE_IDX)
+	{
+		if (IsHLTLoop())
+		{
+			ExecuteHLTLoop<DEBUG>();
+			return;
+		}
+
+		// finishes the instruction started in the middle
+		do
+		{
+			ExecuteMachineCycle(m_bus.BeginMachineCycle());
+			m_bus.EndMachineCycle();
+
+		} while (!IsInstructionExecuted());
+		return;
+	}
+
+	IFF |= m_bus.BeginMachineCycle() & INTE;
+
+	const PredecodedInstr* instr;
+
+	// interrupt processing
+	if (IFF && !EI_PENDING)
+	{
+		INTE = false;
+		IFF = false;
+		HLTA = false;
+		IR = OPCODE_RST7;
+		instr = &m_predecoded[IR];
+	}
+	// normal instruction execution
+	else
+	{
+		EI_PENDING = false;
+
+		if constexpr (DEBUG)
+		{
+			IR = ReadInstrMovePC<DEBUG>(0);
+			instr = &m_predecoded[IR];
+		}
+		else {
+			auto& cachedInstr = FetchCachedInstr();
+			m_instrBytes = cachedInstr.bytes;
+			IR = cachedInstr.bytes[0];
+			PC++;
+			instr = cachedInstr.instr;
+		}
+	}
+
+	(this->*instr->exec)(*instr);
+
+	CC += MACHINE_CC;
+	m_bus.EndMachineCycle();
+}
+
+// the HLT loop, see ExecHLT. one machine cycle per call. the loop is over
+// when the interruption is accepted
+template <class Bus>
+bool dev::CpuI8080Bound<Bus>::IsHLTLoop() const
+{
+	return MC != FIRST_MACHINE_CICLE_IDX && HLTA && IR == OPCODE_HLT;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecuteHLTLoop()
+{
+	IFF |= m_bus.BeginMachineCycle() & INTE;
+	ReadInstrMovePC<DEBUG>(0);
+	if (IFF) {
+		MC = FIRST_MACHINE_CICLE_IDX;
+	}
+	else {
+		PC--;
+	}
+	CC += MACHINE_CC;
+	m_bus.EndMachineCycle();
+}
+
+// executes the HLT loop machine cycles up to _ccEvent, the earliest device
+// event, see Scheduler. the cycles before the event can't accept the
+// interruption, so they are idled through in one batch, then the event machine
+// cycle is executed. the halted cpu is never debugged, so the memory access
+// has no debug bookkeeping. it returns false if the cpu is not halted
+template <class Bus>
+bool dev::CpuI8080Bound<Bus>::ExecuteHalted(const uint64_t _ccEvent)
+{
+	if (!IsHLTLoop()) return false;
+
+	if (_ccEvent > CC)
+	{
+		int machineCycles = static_cast<int>(dev::Min(_ccEvent - CC, uint64_t(INT32_MAX)) / MACHINE_CC);
+		m_bus.IdleMachineCycles(machineCycles);
+		CC += machineCycles * MACHINE_CC;
+	}
+
+	ExecuteHLTLoop<false>();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Block cache
+//
+////////////////////////////////////////////////////////////////////////////
+
+// an instruction length in bytes
+static constexpr uint8_t INSTR_LENS[]
+{
+//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+	1, 3, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, // 0
+	1, 3, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, // 1
+	1, 3, 3, 1, 1, 1, 2, 1, 1, 1, 3, 1, 1, 1, 2, 1, // 2
+	1, 3, 3, 1, 1, 1, 2, 1, 1, 1, 3, 1, 1, 1, 2, 1, // 3
+
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 4
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 5
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 6
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 7
+
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 8
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 9
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // A
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // B
+
+	1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 3, 3, 3, 2, 1, // C
+	1, 1, 3, 2, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1, // D
+	1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 3, 2, 1, // E
+	1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 3, 2, 1  // F
+};
+
+// the instructions transferring the control end a block
+static constexpr bool IsBlockEnd(const uint8_t _opcode)
+{
+	if (_opcode == dev::CpuI8080::OPCODE_HLT) return true;
+	if ((_opcode & 0xC0) != 0xC0) return false;
+
+	switch (_opcode & 0x07)
+	{
+	case 0x00: // Rcc
+	case 0x02: // Jcc
+	case 0x04: // Ccc
+	case 0x07: // RST
+		return true;
+	case 0x01: // RET, PCHL
+		return _opcode == 0xC9 || _opcode == 0xD9 || _opcode == 0xE9;
+	case 0x03: // JMP
+		return _opcode == 0xC3 || _opcode == 0xCB;
+	case 0x05: // CALL
+		return _opcode == 0xCD || _opcode == 0xDD || _opcode == 0xED || _opcode == 0xFD;
+	default:
+		return false;
+	}
+}
+
+// the block is valid if no code was updated since the last check or the code
+// lines it was decoded from were not written
+template <class Bus>
+inline bool dev::CpuI8080Bound<Bus>::IsBlockValid(Block& _block)
+{
+	Memory& memory = m_bus.GetMemory();
+	if (_block.codeUpdates == memory.GetCodeUpdates()) return true;
+
+	bool valid = _block.codeGen == memory.GetCodeGen() &&
+		_block.lineGens[0] == memory.GetCodeLineGen(_block.globalAddr) &&
+		_block.lineGens[1] == memory.GetCodeLineGen(_block.lastGlobalAddr);
+
+	if (valid) _block.codeUpdates = memory.GetCodeUpdates();
+	return valid;
+}
+
+// outputs the instruction at PC. it continues the running block if no jump
+// happened and no cached code was written since the last instruction
+template <class Bus>
+inline auto dev::CpuI8080Bound<Bus>::FetchCachedInstr()
+-> const CachedInstr&
+{
+	if (PC == m_blockNextPC && m_blockInstrIdx < m_block->len &&
+		m_block->codeUpdates == m_bus.GetMemory().GetCodeUpdates())
+	{
+		auto& cachedInstr = m_block->instrs[m_blockInstrIdx++];
+		m_blockNextPC += cachedInstr.len;
+		return cachedInstr;
+	}
+
+	return LookupCachedInstr();
+}
+
+// checks the running block against the code updates, otherwise it looks up
+// the block by the global addr. the written block is decoded again, so
+// self-modifying code runs the written instructions
+template <class Bus>
+auto dev::CpuI8080Bound<Bus>::LookupCachedInstr()
+-> const CachedInstr&
+{
+	Memory& memory = m_bus.GetMemory();
+
+	if (PC == m_blockNextPC && m_blockInstrIdx < m_block->len && IsBlockValid(*m_block))
+	{
+		auto& cachedInstr = m_block->instrs[m_blockInstrIdx++];
+		m_blockNextPC += cachedInstr.len;
+		return cachedInstr;
+	}
+
+	GlobalAddr globalAddr = memory.GetGlobalAddr(PC, Memory::AddrSpace::RAM);
+	auto& block = m_blocks[(globalAddr ^ (globalAddr >> 12)) & (BLOCK_CACHE_LEN - 1)];
+
+	if (block.globalAddr != globalAddr || block.len == 0 || !IsBlockValid(block)) {
+		DecodeBlock(block, globalAddr);
+	}
+
+	m_block = &block;
+
+	// the instruction crossing the page is not cached
+	if (block.len == 0)
+	{
+		uint8_t opcode = memory.CpuReadInstr<false>(PC, Memory::AddrSpace::RAM, 0);
+		m_uncachedInstr.instr = &m_predecoded[opcode];
+		m_uncachedInstr.len = INSTR_LENS[opcode];
+		for (int i = 0; i < m_uncachedInstr.len; i++) {
+			m_uncachedInstr.bytes[i] = memory.CpuReadInstr<false>(PC + i, Memory::AddrSpace::RAM, 0);
+		}
+		return m_uncachedInstr;
+	}
+
+	m_blockInstrIdx = 1;
+	m_blockNextPC = PC + block.instrs[0].len;
+	return block.instrs[0];
+}
+
+// decodes the instructions starting at PC. the memory reads have no side
+// effects without the debug bookkeeping
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::DecodeBlock(Block& _block, const GlobalAddr _globalAddr)
+{
+	Memory& memory = m_bus.GetMemory();
+
+	int addr = PC;
+	int bytesEnd = dev::Min(addr + BLOCK_BYTES_MAX, ((addr >> Memory::PAGE_SHIFT) + 1) << Memory::PAGE_SHIFT);
+
+	_block.globalAddr = _globalAddr;
+	_block.codeGen = memory.GetCodeGen();
+	_block.len = 0;
+
+	while (_block.len < BLOCK_INSTRS_MAX)
+	{
+		uint8_t opcode = memory.CpuReadInstr<false>(addr, Memory::AddrSpace::RAM, 0);
+		uint8_t len = INSTR_LENS[opcode];
+		if (addr + len > bytesEnd) break;
+
+		auto& cachedInstr = _block.instrs[_block.len++];
+		cachedInstr.instr = &m_predecoded[opcode];
+		cachedInstr.len = len;
+		for (int i = 0; i < len; i++) {
+			cachedInstr.bytes[i] = memory.CpuReadInstr<false>(addr + i, Memory::AddrSpace::RAM, 0);
+		}
+		addr += len;
+
+		if (IsBlockEnd(opcode)) break;
+	}
+
+	if (_block.len == 0) return;
+
+	_block.lastGlobalAddr = _globalAddr + (addr - PC) - 1;
+	memory.CacheCodeLines(_block.globalAddr, _block.lastGlobalAddr);
+	_block.lineGens[0] = memory.GetCodeLineGen(_block.globalAddr);
+	_block.lineGens[1] = memory.GetCodeLineGen(_block.lastGlobalAddr);
+	_block.codeUpdates = memory.GetCodeUpdates();
+}
+
+// swaps the handlers, so the memory access skips the debug bookkeeping when
+// it's not required
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::SetMemoryDebug(const bool _memoryDebug)
+{
+	m_memoryDebug = _memoryDebug;
+
+	if (m_memoryDebug) {
+		InitPredecoded<true>();
+	}
+	else {
+		InitPredecoded<false>();
+	}
+}
+
 bool dev::CpuI8080::IsInstructionExecuted() const
 {
 	return MC == FIRST_MACHINE_CICLE_IDX || HLTA;
@@ -142,7 +460,8 @@ auto dev::CpuI8080::GetInstrCC(const uint8_t _opcode)
 	return M_CYCLES[_opcode] * 4;
 }
 
-void dev::CpuI8080::Decode()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::Decode()
 {
 	switch (IR)
 	{
@@ -330,8 +649,8 @@ void dev::CpuI8080::Decode()
 
 		case 0x27: DAA(); break; // DAA
 		case 0x2F: A = ~A; break; // CMA
-		case 0x37: FC = true; break; // STC
-		case 0x3F: FC = !FC; break; // CMC
+		case 0x37: SET_FC(true); break; // STC
+		case 0x3F: F ^= FLAG_C; break; // CMC
 
 		case 0x07: RLC(); break; // RLC (rotate left)
 		case 0x0F: RRC(); break; // RRC (rotate right)
@@ -451,6 +770,724 @@ void dev::CpuI8080::Decode()
 	MC %= M_CYCLES[IR];
 }
 
+////////////////////////////////////////////////////////////////////////////
+//
+// Instruction-granular execution
+//
+////////////////////////////////////////////////////////////////////////////
+
+// resolves the handler and operands of every opcode the same way Decode does
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::InitPredecoded()
+{
+	uint8_t* regs[] = { &B, &C, &D, &E, &H, &L, nullptr, &A };
+	RegPair* regPairs[] = { &BCP, &DEP, &HLP, &SPP };
+	// NZ, Z, NC, C, PO, PE, P, M
+	static constexpr uint8_t condFlags[] = { 0x40, 0x01, 0x04, 0x80 };
+
+	for (int opcode = 0; opcode < 256; opcode++)
+	{
+		auto& instr = m_predecoded[opcode];
+		instr = {};
+
+		uint8_t ddd = (opcode >> 3) & 0x07;
+		uint8_t sss = opcode & 0x07;
+		uint8_t rp = (opcode >> 4) & 0x03;
+		bool memDst = ddd == 6;
+		bool memSrc = sss == 6;
+		bool bit3 = opcode & 0x08;
+
+		instr.reg1 = regs[ddd];
+		instr.reg2 = regs[sss];
+		instr.regPair = regPairs[rp];
+		instr.flagMask = condFlags[ddd >> 1];
+		instr.flagValue = (ddd & 1) ? instr.flagMask : 0;
+
+		switch (opcode >> 6)
+		{
+		case 0:
+			switch (sss)
+			{
+			case 0: instr.exec = &CpuI8080Bound::ExecNOP; break;
+			case 1: instr.exec = bit3 ? &CpuI8080Bound::ExecDAD : &CpuI8080Bound::ExecLXI<DEBUG>;
+				instr.reg1 = &instr.regPair->h;
+				instr.reg2 = &instr.regPair->l;
+				break;
+			case 2:
+				switch (rp)
+				{
+				case 0: case 1:
+					instr.exec = bit3 ? &CpuI8080Bound::ExecLoadRegPtr<DEBUG> : &CpuI8080Bound::ExecSTAX<DEBUG>;
+					instr.reg1 = &A;
+					break;
+				case 2: instr.exec = bit3 ? &CpuI8080Bound::ExecLHLD<DEBUG> : &CpuI8080Bound::ExecSHLD<DEBUG>; break;
+				case 3: instr.exec = bit3 ? &CpuI8080Bound::ExecLDA<DEBUG> : &CpuI8080Bound::ExecSTA<DEBUG>; break;
+				}
+				break;
+			case 3: instr.exec = bit3 ? &CpuI8080Bound::ExecDCX : &CpuI8080Bound::ExecINX; break;
+			case 4: instr.exec = memDst ? &CpuI8080Bound::ExecINRMem<DEBUG> : &CpuI8080Bound::ExecINR; break;
+			case 5: instr.exec = memDst ? &CpuI8080Bound::ExecDCRMem<DEBUG> : &CpuI8080Bound::ExecDCR; break;
+			case 6: instr.exec = memDst ? &CpuI8080Bound::ExecMVIMemData<DEBUG> : &CpuI8080Bound::ExecMVIRegData<DEBUG>; break;
+			case 7:
+			{
+				static constexpr ExecFunc accOps[] = {
+					&CpuI8080Bound::ExecRLC, &CpuI8080Bound::ExecRRC, &CpuI8080Bound::ExecRAL, &CpuI8080Bound::ExecRAR,
+					&CpuI8080Bound::ExecDAA, &CpuI8080Bound::ExecCMA, &CpuI8080Bound::ExecSTC, &CpuI8080Bound::ExecCMC };
+				instr.exec = accOps[ddd];
+				break;
+			}
+			}
+			break;
+
+		case 1:
+			if (opcode == OPCODE_HLT) {
+				instr.exec = &CpuI8080Bound::ExecHLT<DEBUG>;
+			}
+			else if (memSrc) {
+				instr.exec = &CpuI8080Bound::ExecLoadRegPtr<DEBUG>;
+				instr.regPair = &HLP;
+			}
+			else if (memDst) {
+				// MOV M,L keeps the known defect, see ExecMOVMemL
+				instr.exec = sss == 5 ? &CpuI8080Bound::ExecMOVMemL : &CpuI8080Bound::ExecMOVMemReg<DEBUG>;
+			}
+			else {
+				instr.exec = &CpuI8080Bound::ExecMOVRegReg;
+			}
+			break;
+
+		case 2:
+		{
+			static constexpr ExecFunc aluOps[] = {
+				&CpuI8080Bound::ExecADD, &CpuI8080Bound::ExecADD, &CpuI8080Bound::ExecSUB, &CpuI8080Bound::ExecSUB,
+				&CpuI8080Bound::ExecANA, &CpuI8080Bound::ExecXRA, &CpuI8080Bound::ExecORA, &CpuI8080Bound::ExecCMP };
+			static constexpr ExecFunc aluMemOps[] = {
+				&CpuI8080Bound::ExecADDMem<DEBUG>, &CpuI8080Bound::ExecADDMem<DEBUG>, &CpuI8080Bound::ExecSUBMem<DEBUG>, &CpuI8080Bound::ExecSUBMem<DEBUG>,
+				&CpuI8080Bound::ExecANAMem<DEBUG>, &CpuI8080Bound::ExecXRAMem<DEBUG>, &CpuI8080Bound::ExecORAMem<DEBUG>, &CpuI8080Bound::ExecCMPMem<DEBUG> };
+			instr.exec = memSrc ? aluMemOps[ddd] : aluOps[ddd];
+			// the carry-in of ADC and SBB
+			instr.flagMask = (ddd == 1 || ddd == 3) ? 0x01 : 0;
+			break;
+		}
+
+		case 3:
+			switch (sss)
+			{
+			case 0: instr.exec = &CpuI8080Bound::ExecRETCond<DEBUG>; break;
+			case 1:
+				if (!bit3) {
+					instr.exec = rp == 3 ? &CpuI8080Bound::ExecPOPPSW<DEBUG> : &CpuI8080Bound::ExecPOP<DEBUG>;
+					instr.reg1 = rp == 3 ? &A : &instr.regPair->h;
+					instr.reg2 = rp == 3 ? &F : &instr.regPair->l;
+				}
+				else {
+					static constexpr ExecFunc ops[] = {
+						&CpuI8080Bound::ExecRET<DEBUG>, &CpuI8080Bound::ExecRET<DEBUG>, &CpuI8080Bound::ExecPCHL, &CpuI8080Bound::ExecSPHL };
+					instr.exec = ops[rp];
+				}
+				break;
+			case 2: instr.exec = &CpuI8080Bound::ExecJMP<DEBUG>; break;
+			case 3:
+			{
+				static constexpr ExecFunc ops[] = {
+					&CpuI8080Bound::ExecJMP<DEBUG>, &CpuI8080Bound::ExecJMP<DEBUG>, &CpuI8080Bound::ExecOUT<DEBUG>, &CpuI8080Bound::ExecIN<DEBUG>,
+					&CpuI8080Bound::ExecXTHL<DEBUG>, &CpuI8080Bound::ExecXCHG, &CpuI8080Bound::ExecDI, &CpuI8080Bound::ExecEI };
+				instr.exec = ops[ddd];
+				instr.flagMask = instr.flagValue = 0;
+				break;
+			}
+			case 4: instr.exec = &CpuI8080Bound::ExecCALL<DEBUG>; break;
+			case 5:
+				if (!bit3) {
+					instr.exec = &CpuI8080Bound::ExecPUSH<DEBUG>;
+					instr.reg1 = rp == 3 ? &A : &instr.regPair->h;
+					instr.reg2 = rp == 3 ? &F : &instr.regPair->l;
+				}
+				else {
+					instr.exec = &CpuI8080Bound::ExecCALL<DEBUG>;
+					instr.flagMask = instr.flagValue = 0;
+				}
+				break;
+			case 6:
+			{
+				static constexpr ExecFunc ops[] = {
+					&CpuI8080Bound::ExecADI<DEBUG>, &CpuI8080Bound::ExecADI<DEBUG>, &CpuI8080Bound::ExecSBI<DEBUG>, &CpuI8080Bound::ExecSBI<DEBUG>,
+					&CpuI8080Bound::ExecANI<DEBUG>, &CpuI8080Bound::ExecXRI<DEBUG>, &CpuI8080Bound::ExecORI<DEBUG>, &CpuI8080Bound::ExecCPI<DEBUG> };
+				instr.exec = ops[ddd];
+				// the carry-in of ACI and SBI
+				instr.flagMask = (ddd == 1 || ddd == 3) ? 0x01 : 0;
+				break;
+			}
+			case 7: instr.exec = &CpuI8080Bound::ExecRST<DEBUG>; break;
+			}
+			break;
+		}
+	}
+}
+
+// closes the current machine cycle and starts the next one
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::NextMachineCycle()
+{
+	CC += MACHINE_CC;
+	m_bus.EndMachineCycle();
+
+	IFF |= m_bus.BeginMachineCycle() & INTE;
+}
+
+template <class Bus>
+bool dev::CpuI8080Bound<Bus>::CheckCondition(const PredecodedInstr& _instr)
+{
+	return (F & _instr.flagMask) == _instr.flagValue;
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecNOP(const PredecodedInstr& _instr) {}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecMOVRegReg(const PredecodedInstr& _instr)
+{
+	TMP = *_instr.reg2;
+	NextMachineCycle();
+	*_instr.reg1 = TMP;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecLoadRegPtr(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	*_instr.reg1 = ReadByte<DEBUG>(_instr.regPair->word);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecMOVMemReg(const PredecodedInstr& _instr)
+{
+	TMP = *_instr.reg2;
+	NextMachineCycle();
+	WriteByte<DEBUG>(HL, TMP, Memory::AddrSpace::RAM, 0);
+}
+
+// KNOWN DEFECT: MOV M,L takes one machine cycle and never writes L to (HL).
+// the real i8080 takes two machine cycles (8 cc) and writes the byte like
+// the other MOV M,r. the bug comes from M_CYCLES[0x75] = 1, so MOVMemReg in
+// the machine cycle path is cut off before its write cycle. it is kept here
+// to stay cycle and memory exact with the machine cycle path. fixing it means
+// setting M_CYCLES[0x75] to 2 and routing 0x75 to ExecMOVMemReg
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecMOVMemL(const PredecodedInstr& _instr)
+{
+	TMP = L;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecMVIRegData(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	*_instr.reg1 = ReadInstrMovePC<DEBUG>(1);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecMVIMemData(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	TMP = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	WriteByte<DEBUG>(HL, TMP, Memory::AddrSpace::RAM, 0);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecLDA(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	W = ReadInstrMovePC<DEBUG>(2);
+	NextMachineCycle();
+	A = ReadByte<DEBUG>(WZ);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecSTA(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	W = ReadInstrMovePC<DEBUG>(2);
+	NextMachineCycle();
+	WriteByte<DEBUG>(WZ, A, Memory::AddrSpace::RAM, 0);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecSTAX(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	WriteByte<DEBUG>(_instr.regPair->word, A, Memory::AddrSpace::RAM, 0);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecLXI(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	*_instr.reg2 = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	*_instr.reg1 = ReadInstrMovePC<DEBUG>(2);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecLHLD(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	W = ReadInstrMovePC<DEBUG>(2);
+	NextMachineCycle();
+	L = ReadByte<DEBUG>(WZ, Memory::AddrSpace::RAM, 0);
+	WZ++;
+	NextMachineCycle();
+	H = ReadByte<DEBUG>(WZ, Memory::AddrSpace::RAM, 1);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecSHLD(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	W = ReadInstrMovePC<DEBUG>(2);
+	NextMachineCycle();
+	WriteByte<DEBUG>(WZ, L, Memory::AddrSpace::RAM, 0);
+	WZ++;
+	NextMachineCycle();
+	WriteByte<DEBUG>(WZ, H, Memory::AddrSpace::RAM, 1);
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecSPHL(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	SP = HL;
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecXCHG(const PredecodedInstr& _instr) { XCHG(); }
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecXTHL(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	Z = ReadByte<DEBUG>(SP, Memory::AddrSpace::STACK, 0);
+	NextMachineCycle();
+	W = ReadByte<DEBUG>(SP + 1u, Memory::AddrSpace::STACK, 1);
+	NextMachineCycle();
+	WriteByte<DEBUG>(SP, L, Memory::AddrSpace::STACK, 1);
+	NextMachineCycle();
+	WriteByte<DEBUG>(SP + 1u, H, Memory::AddrSpace::STACK, 0);
+	NextMachineCycle();
+	HL = WZ;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecPUSH(const PredecodedInstr& _instr)
+{
+	SP--;
+	NextMachineCycle();
+	WriteByte<DEBUG>(SP, *_instr.reg1, Memory::AddrSpace::STACK, 0);
+	NextMachineCycle();
+	SP--;
+	NextMachineCycle();
+	WriteByte<DEBUG>(SP, *_instr.reg2, Memory::AddrSpace::STACK, 1);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecPOP(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	*_instr.reg2 = ReadByte<DEBUG>(SP, Memory::AddrSpace::STACK, 0);
+	SP++;
+	NextMachineCycle();
+	*_instr.reg1 = ReadByte<DEBUG>(SP, Memory::AddrSpace::STACK, 1);
+	SP++;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecPOPPSW(const PredecodedInstr& _instr)
+{
+	ExecPOP<DEBUG>(_instr);
+	F &= PSW_NUL_FLAGS;
+	F |= PSW_INIT;
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecADD(const PredecodedInstr& _instr)
+{
+	ADD(A, *_instr.reg2, F & _instr.flagMask);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecADDMem(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	TMP = ReadByte<DEBUG>(HL);
+	ADD(ACT, TMP, F & _instr.flagMask);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecADI(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	TMP = ReadInstrMovePC<DEBUG>(1);
+	ADD(ACT, TMP, F & _instr.flagMask);
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecSUB(const PredecodedInstr& _instr)
+{
+	SUB(A, *_instr.reg2, F & _instr.flagMask);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecSUBMem(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	TMP = ReadByte<DEBUG>(HL);
+	SUB(ACT, TMP, F & _instr.flagMask);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecSBI(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	TMP = ReadInstrMovePC<DEBUG>(1);
+	SUB(ACT, TMP, F & _instr.flagMask);
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecDAD(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	ACT = _instr.regPair->l;
+	TMP = L;
+	int res = ACT + TMP;
+	SET_FC(res & 0x100);
+	L = (uint8_t)(res);
+
+	NextMachineCycle();
+	ACT = _instr.regPair->h;
+	TMP = H;
+	res = ACT + TMP + (FC ? 1 : 0);
+	SET_FC(res & 0x100);
+	H = (uint8_t)(res);
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecINR(const PredecodedInstr& _instr)
+{
+	TMP = *_instr.reg1;
+	TMP++;
+	SetZSPAC(TMP, (TMP & 0xF) == 0);
+	NextMachineCycle();
+	*_instr.reg1 = TMP;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecINRMem(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	TMP = ReadByte<DEBUG>(HL);
+	TMP++;
+	SetZSPAC(TMP, (TMP & 0xF) == 0);
+	NextMachineCycle();
+	WriteByte<DEBUG>(HL, TMP, Memory::AddrSpace::RAM, 0);
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecDCR(const PredecodedInstr& _instr)
+{
+	TMP = *_instr.reg1;
+	TMP--;
+	SetZSPAC(TMP, (TMP & 0xF) != 0xF);
+	NextMachineCycle();
+	*_instr.reg1 = TMP;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecDCRMem(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	TMP = ReadByte<DEBUG>(HL);
+	TMP--;
+	SetZSPAC(TMP, (TMP & 0xF) != 0xF);
+	NextMachineCycle();
+	WriteByte<DEBUG>(HL, TMP, Memory::AddrSpace::RAM, 0);
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecINX(const PredecodedInstr& _instr)
+{
+	WZ = (uint16_t)(_instr.regPair->word + 1);
+	NextMachineCycle();
+	_instr.regPair->word = WZ;
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecDCX(const PredecodedInstr& _instr)
+{
+	WZ = (uint16_t)(_instr.regPair->word - 1);
+	NextMachineCycle();
+	_instr.regPair->word = WZ;
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecDAA(const PredecodedInstr& _instr) { DAA(); }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecCMA(const PredecodedInstr& _instr) { A = ~A; }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecSTC(const PredecodedInstr& _instr) { SET_FC(true); }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecCMC(const PredecodedInstr& _instr) { F ^= FLAG_C; }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecRLC(const PredecodedInstr& _instr) { RLC(); }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecRRC(const PredecodedInstr& _instr) { RRC(); }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecRAL(const PredecodedInstr& _instr) { RAL(); }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecRAR(const PredecodedInstr& _instr) { RAR(); }
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecANA(const PredecodedInstr& _instr) { ANA(*_instr.reg2); }
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecANAMem(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	ANA(ReadByte<DEBUG>(HL));
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecANI(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	ANA(ReadInstrMovePC<DEBUG>(1));
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecXRA(const PredecodedInstr& _instr) { XRA(*_instr.reg2); }
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecXRAMem(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	XRA(ReadByte<DEBUG>(HL));
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecXRI(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	XRA(ReadInstrMovePC<DEBUG>(1));
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecORA(const PredecodedInstr& _instr) { ORA(*_instr.reg2); }
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecORAMem(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	ORA(ReadByte<DEBUG>(HL));
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecORI(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	ORA(ReadInstrMovePC<DEBUG>(1));
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecCMP(const PredecodedInstr& _instr) { CMP(*_instr.reg2); }
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecCMPMem(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	CMP(ReadByte<DEBUG>(HL));
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecCPI(const PredecodedInstr& _instr)
+{
+	ACT = A;
+	NextMachineCycle();
+	CMP(ReadInstrMovePC<DEBUG>(1));
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecJMP(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	W = ReadInstrMovePC<DEBUG>(2);
+	if (CheckCondition(_instr))
+	{
+		PC = WZ;
+	}
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecPCHL(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	PC = HL;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecCALL(const PredecodedInstr& _instr)
+{
+	bool condition = CheckCondition(_instr);
+
+	SP -= condition ? 1 : 0;
+	NextMachineCycle();
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	W = ReadInstrMovePC<DEBUG>(2);
+	NextMachineCycle();
+	// end execution
+	if (!condition) return;
+
+	WriteByte<DEBUG>(SP, PCH, Memory::AddrSpace::STACK, 0);
+	SP--;
+	NextMachineCycle();
+	WriteByte<DEBUG>(SP, PCL, Memory::AddrSpace::STACK, 1);
+	NextMachineCycle();
+	PC = WZ;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecRST(const PredecodedInstr& _instr)
+{
+	SP--;
+	NextMachineCycle();
+	WriteByte<DEBUG>(SP, PCH, Memory::AddrSpace::STACK, 0);
+	SP--;
+	NextMachineCycle();
+	W = 0;
+	Z = IR & 0x38;
+	WriteByte<DEBUG>(SP, PCL, Memory::AddrSpace::STACK, 1);
+	NextMachineCycle();
+	PC = WZ;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecRET(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	Z = ReadByte<DEBUG>(SP, Memory::AddrSpace::STACK, 0);
+	SP++;
+	NextMachineCycle();
+	W = ReadByte<DEBUG>(SP, Memory::AddrSpace::STACK, 1);
+	SP++;
+	PC = WZ;
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecRETCond(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	if (!CheckCondition(_instr)) return;
+
+	ExecRET<DEBUG>(_instr);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecIN(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	W = 0;
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	A = m_bus.PortIn(Z);
+}
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecOUT(const PredecodedInstr& _instr)
+{
+	NextMachineCycle();
+	W = 0;
+	Z = ReadInstrMovePC<DEBUG>(1);
+	NextMachineCycle();
+	m_bus.PortOut(Z, A);
+}
+
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecDI(const PredecodedInstr& _instr) { INTE = false; }
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ExecEI(const PredecodedInstr& _instr) { INTE = true; EI_PENDING = true; }
+
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::ExecHLT(const PredecodedInstr& _instr)
+{
+	PC--;
+	NextMachineCycle();
+	ReadInstrMovePC<DEBUG>(0);
+	// to loop into the M2 of HLT, see ExecuteInstr
+	if (!IFF) {
+		HLTA = true;
+		MC = 1;
+		PC--;
+	}
+}
+
 
 ////////////////////////////////////////////////////////////////////////////
 //
@@ -459,24 +1496,39 @@ void dev::CpuI8080::Decode()
 ////////////////////////////////////////////////////////////////////////////
 
 // _byteNum is the instruction number of byte (0, 2)
-uint8_t dev::CpuI8080::ReadInstrMovePC(uint8_t _byteNum)
+template <class Bus>
+template <bool DEBUG>
+uint8_t dev::CpuI8080Bound<Bus>::ReadInstrMovePC(uint8_t _byteNum)
 {
-	uint8_t opcode = m_memory.CpuReadInstr(PC, Memory::AddrSpace::RAM, _byteNum);
+	// the non-debug execution takes the operands fetched by FetchCachedInstr
+	if constexpr (!DEBUG)
+	{
+		if (_byteNum) {
+			PC++;
+			return m_instrBytes[_byteNum];
+		}
+	}
+
+	uint8_t opcode = m_bus.template CpuReadInstr<DEBUG>(PC, Memory::AddrSpace::RAM, _byteNum);
 
 	PC++;
 	return opcode;
 }
 
-uint8_t dev::CpuI8080::ReadByte(const Addr _addr, 
+template <class Bus>
+template <bool DEBUG>
+uint8_t dev::CpuI8080Bound<Bus>::ReadByte(const Addr _addr, 
 	Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
 {
-	return m_memory.CpuRead(_addr, _addrSpace, _byteNum);
+	return m_bus.template CpuRead<DEBUG>(_addr, _addrSpace, _byteNum);
 }
 
-void dev::CpuI8080::WriteByte(const Addr _addr, uint8_t _value, 
+template <class Bus>
+template <bool DEBUG>
+void dev::CpuI8080Bound<Bus>::WriteByte(const Addr _addr, uint8_t _value, 
 	Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
 {
-	m_memory.CpuWrite(_addr, _value, _addrSpace, _byteNum);
+	m_bus.template CpuWrite<DEBUG>(_addr, _value, _addrSpace, _byteNum);
 }
 
 
@@ -511,55 +1563,101 @@ bool dev::CpuI8080::GetIFF() const { return IFF; }
 bool dev::CpuI8080::GetHLTA() const { return HLTA; }
 auto dev::CpuI8080::GetMachineCycles() const -> uint8_t { return MC; }
 
+auto dev::CpuI8080::GetState() const -> State
+{
+	State state;
+	state.cc = CC;
+	state.regs.pc.word = PC;
+	state.regs.sp.word = SP;
+	state.regs.psw.af.word = PSW;
+	state.regs.bc.word = BC;
+	state.regs.de.word = DE;
+	state.regs.hl.word = HL;
+	state.regs.ir = IR;
+	state.regs.tmp = TMP;
+	state.regs.act = ACT;
+	state.regs.wz.word = WZ;
+	state.ints.mc = MC;
+	state.ints.inte = INTE;
+	state.ints.iff = IFF;
+	state.ints.hlta = HLTA;
+	state.ints.eiPending = EI_PENDING;
+	return state;
+}
+
+void dev::CpuI8080::PackState() { m_state = GetState(); }
+
+void dev::CpuI8080::UnpackState()
+{
+	CC = m_state.cc;
+	PC = m_state.regs.pc.word;
+	SP = m_state.regs.sp.word;
+	PSW = m_state.regs.psw.af.word;
+	BC = m_state.regs.bc.word;
+	DE = m_state.regs.de.word;
+	HL = m_state.regs.hl.word;
+	IR = m_state.regs.ir;
+	TMP = m_state.regs.tmp;
+	ACT = m_state.regs.act;
+	WZ = m_state.regs.wz.word;
+	MC = m_state.ints.mc;
+	INTE = m_state.ints.inte;
+	IFF = m_state.ints.iff;
+	HLTA = m_state.ints.hlta;
+	EI_PENDING = m_state.ints.eiPending;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //
 // Instruction helpers
 //
 ////////////////////////////////////////////////////////////////////////////
 
-static constexpr bool parityTable[]
-{
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	false, true, true, false, true, false, false, true, true, false, false, true, false, true, true, false,
-	true, false, false, true, false, true, true, false, false, true, true, false, true, false, false, true,
-};
-// returns the parity of a uint8_t: 0 if a number of set bits of `val` is odd, else 1
-bool dev::CpuI8080::GetParity(uint8_t _val)
+// the sign, zero, and parity flags of every byte value.
+// the parity flag is set if a number of set bits is even
+static constexpr auto zspTable = []()
 {
-	return parityTable[_val];
-}
-// determines if there was a carry between bit 'bit_no' and 'bit_no - 1' during the calculation of 'a + b + cy'.
-bool dev::CpuI8080::GetCarry(int _bit_no, uint8_t _a, uint8_t _b, bool _cy)
+	std::array<uint8_t, 256> table{};
+	for (int val = 0; val < 256; val++)
+	{
+		int bits = 0;
+		for (int i = 0; i < 8; i++) bits += (val >> i) & 1;
+
+		table[val] = (val & 0x80 ? FLAG_S : 0) | (val == 0 ? FLAG_Z : 0) | (bits & 1 ? 0 : FLAG_P);
+	}
+	return table;
+}();
+
+// the carry and the auxiliary carry flags of the addition. the index is
+// made of bits 7 and 3 of both operands and the result, see GetCarryIdx.
+// a carry out of a bit is set if both operand bits are set, or if any of
+// them is set while the result bit is not
+static constexpr auto carryTable = []()
+{
+	std::array<uint8_t, 128> table{};
+	auto carry = [](int _idx) { return (_idx & 0b110) == 0b110 || ((_idx & 0b110) && !(_idx & 0b001)); };
+	for (int idx = 0; idx < 128; idx++)
+	{
+		table[idx] = (carry(idx >> 4) ? FLAG_C : 0) | (carry(idx & 0b111) ? FLAG_AC : 0);
+	}
+	return table;
+}();
+
+static inline int GetCarryIdx(uint8_t _a, uint8_t _b, uint8_t _res)
 {
-	int result = _a + _b + (_cy ? 1 : 0);
-	int carry = result ^ _a ^ _b;
-	return (carry & (1 << _bit_no)) != 0;
+	return ((_a & 0x88) >> 1) | ((_b & 0x88) >> 2) | ((_res & 0x88) >> 3);
 }
 
-void dev::CpuI8080::SetZSP(uint8_t _val)
+// sets the flags of INR and DCR, the carry flag is kept
+void dev::CpuI8080::SetZSPAC(uint8_t _val, bool _ac)
 {
-	FZ = _val == 0;
-	FS = _val & 0b10000000;
-	FP = GetParity(_val);
+	F = (F & (FLAGS_UNUSED | FLAG_C)) | zspTable[_val] | (_ac ? FLAG_AC : 0);
 }
 
 // rotate register A left
 void dev::CpuI8080::RLC()
 {
-	FC = A & 0x80;
+	SET_FC(A & 0x80);
 	A = (uint8_t)(A << 1);
 	A += (uint8_t)(FC ? 1 : 0);
 }
@@ -567,7 +1665,7 @@ void dev::CpuI8080::RLC()
 // rotate register A right
 void dev::CpuI8080::RRC()
 {
-	FC = (A & 1) == 1;
+	SET_FC((A & 1) == 1);
 	A = (uint8_t)(A >> 1);
 	A |= (uint8_t)(FC ? 1 << 7 : 0);
 }
@@ -576,7 +1674,7 @@ void dev::CpuI8080::RRC()
 void dev::CpuI8080::RAL()
 {
 	bool cy = FC;
-	FC = A & 0x80;
+	SET_FC(A & 0x80);
 	A = (uint8_t)(A << 1);
 	A |= (uint8_t)(cy ? 1 : 0);
 }
@@ -585,12 +1683,13 @@ void dev::CpuI8080::RAL()
 void dev::CpuI8080::RAR()
 {
 	bool cy = FC;
-	FC = (A & 1) == 1;
+	SET_FC((A & 1) == 1);
 	A = (uint8_t)(A >> 1);
 	A |= (uint8_t)(cy ? 1 << 7 : 0);
 }
 
-void dev::CpuI8080::MOVRegReg(uint8_t& _regDest, uint8_t _regSrc)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::MOVRegReg(uint8_t& _regDest, uint8_t _regSrc)
 {
 	switch (MC) {
 	case 0:
@@ -602,7 +1701,8 @@ void dev::CpuI8080::MOVRegReg(uint8_t& _regDest, uint8_t _regSrc)
 	}
 }
 
-void dev::CpuI8080::LoadRegPtr(uint8_t& _regDest, Addr _addr)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::LoadRegPtr(uint8_t& _regDest, Addr _addr)
 {
 	switch (MC) {
 	case 0:
@@ -613,7 +1713,8 @@ void dev::CpuI8080::LoadRegPtr(uint8_t& _regDest, Addr _addr)
 	}
 }
 
-void dev::CpuI8080::MOVMemReg(uint8_t _sss)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::MOVMemReg(uint8_t _sss)
 {
 	switch (MC) {
 	case 0:
@@ -625,7 +1726,8 @@ void dev::CpuI8080::MOVMemReg(uint8_t _sss)
 	}
 }
 
-void dev::CpuI8080::MVIRegData(uint8_t& _regDest)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::MVIRegData(uint8_t& _regDest)
 {
 	switch (MC) {
 	case 0:
@@ -636,7 +1738,8 @@ void dev::CpuI8080::MVIRegData(uint8_t& _regDest)
 	}
 }
 
-void dev::CpuI8080::MVIMemData()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::MVIMemData()
 {
 	switch (MC) {
 	case 0:
@@ -650,7 +1753,8 @@ void dev::CpuI8080::MVIMemData()
 	}
 }
 
-void dev::CpuI8080::LDA()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::LDA()
 {
 	switch (MC) {
 	case 0:
@@ -667,7 +1771,8 @@ void dev::CpuI8080::LDA()
 	}
 }
 
-void dev::CpuI8080::STA()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::STA()
 {
 	switch (MC) {
 	case 0:
@@ -684,7 +1789,8 @@ void dev::CpuI8080::STA()
 	}
 }
 
-void dev::CpuI8080::STAX(Addr _addr)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::STAX(Addr _addr)
 {
 	switch (MC) {
 	case 0:
@@ -695,7 +1801,8 @@ void dev::CpuI8080::STAX(Addr _addr)
 	}
 }
 
-void dev::CpuI8080::LXI(uint8_t& _regH, uint8_t& _regL)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::LXI(uint8_t& _regH, uint8_t& _regL)
 {
 	switch (MC) {
 	case 0:
@@ -709,7 +1816,8 @@ void dev::CpuI8080::LXI(uint8_t& _regH, uint8_t& _regL)
 	}
 }
 
-void dev::CpuI8080::LHLD()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::LHLD()
 {
 	switch (MC) {
 	case 0:
@@ -730,7 +1838,8 @@ void dev::CpuI8080::LHLD()
 	}
 }
 
-void dev::CpuI8080::SHLD()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::SHLD()
 {
 	switch (MC) {
 	case 0:
@@ -751,7 +1860,8 @@ void dev::CpuI8080::SHLD()
 	}
 }
 
-void dev::CpuI8080::SPHL()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::SPHL()
 {
 	switch (MC) {
 	case 0:
@@ -773,7 +1883,8 @@ void dev::CpuI8080::XCHG()
 	L = TMP;
 }
 
-void dev::CpuI8080::XTHL()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::XTHL()
 {
 	switch (MC) {
 	case 0:
@@ -796,7 +1907,8 @@ void dev::CpuI8080::XTHL()
 	}
 }
 
-void dev::CpuI8080::PUSH(uint8_t _hb, uint8_t _lb)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::PUSH(uint8_t _hb, uint8_t _lb)
 {
 	switch (MC) {
 	case 0:
@@ -814,7 +1926,8 @@ void dev::CpuI8080::PUSH(uint8_t _hb, uint8_t _lb)
 	}
 }
 
-void dev::CpuI8080::POP(uint8_t& _regH, uint8_t& _regL)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::POP(uint8_t& _regH, uint8_t& _regL)
 {
 	switch (MC) {
 	case 0:
@@ -833,14 +1946,12 @@ void dev::CpuI8080::POP(uint8_t& _regH, uint8_t& _regL)
 // adds a value (+ an optional carry flag) to a register
 void dev::CpuI8080::ADD(uint8_t _a, uint8_t _b, bool _cy)
 {
-
 	A = (uint8_t)(_a + _b + (_cy ? 1 : 0));
-	FC = GetCarry(8, _a, _b, _cy);
-	FAC = GetCarry(4, _a, _b, _cy);
-	SetZSP(A);
+	F = (F & FLAGS_UNUSED) | zspTable[A] | carryTable[GetCarryIdx(_a, _b, A)];
 }
 
-void dev::CpuI8080::ADDMem(bool _cy)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ADDMem(bool _cy)
 {
 	switch (MC) {
 	case 0:
@@ -853,7 +1964,8 @@ void dev::CpuI8080::ADDMem(bool _cy)
 	}
 }
 
-void dev::CpuI8080::ADI(bool _cy)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ADI(bool _cy)
 {
 	switch (MC) {
 	case 0:
@@ -871,10 +1983,11 @@ void dev::CpuI8080::ADI(bool _cy)
 void dev::CpuI8080::SUB(uint8_t _a, uint8_t _b, bool _cy)
 {
 	ADD(_a, (uint8_t)(~_b), !_cy);
-	FC = !FC;
+	F ^= FLAG_C;
 }
 
-void dev::CpuI8080::SUBMem(bool _cy)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::SUBMem(bool _cy)
 {
 	switch (MC) {
 	case 0:
@@ -887,7 +2000,8 @@ void dev::CpuI8080::SUBMem(bool _cy)
 	}
 }
 
-void dev::CpuI8080::SBI(bool _cy)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::SBI(bool _cy)
 {
 	switch (MC) {
 	case 0:
@@ -900,7 +2014,8 @@ void dev::CpuI8080::SBI(bool _cy)
 	}
 }
 
-void dev::CpuI8080::DAD(RegPair _regPair)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::DAD(RegPair _regPair)
 {
 	switch (MC) {
 	case 0:
@@ -909,7 +2024,7 @@ void dev::CpuI8080::DAD(RegPair _regPair)
 			ACT = _regPair.l;
 			TMP = L;
 			int res = ACT + TMP;
-			FC = res & 0x100;
+			SET_FC(res & 0x100);
 			L = (uint8_t)(res);
 			return;
 		}
@@ -917,21 +2032,21 @@ void dev::CpuI8080::DAD(RegPair _regPair)
 			ACT = _regPair.h;
 			TMP = H;
 			int result = ACT + TMP + (FC ? 1 : 0);
-			FC = result & 0x100;
+			SET_FC(result & 0x100);
 			H = (uint8_t)(result);
 			return;
 		}
 	}
 }
 
-void dev::CpuI8080::INR(uint8_t& _regDest)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::INR(uint8_t& _regDest)
 {
 	switch (MC) {
 	case 0:
 		TMP = _regDest;
 		TMP++;
-		FAC = (TMP & 0xF) == 0;
-		SetZSP(TMP);
+		SetZSPAC(TMP, (TMP & 0xF) == 0);
 		return;
 	case 1:
 		_regDest = TMP;
@@ -939,7 +2054,8 @@ void dev::CpuI8080::INR(uint8_t& _regDest)
 	}
 }
 
-void dev::CpuI8080::INRMem()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::INRMem()
 {
 	switch (MC) {
 	case 0:
@@ -947,8 +2063,7 @@ void dev::CpuI8080::INRMem()
 	case 1:
 		TMP = ReadByte(HL);
 		TMP++;
-		FAC = (TMP & 0xF) == 0;
-		SetZSP(TMP);
+		SetZSPAC(TMP, (TMP & 0xF) == 0);
 		return;
 	case 2:
 		WriteByte(HL, TMP, Memory::AddrSpace::RAM, 0);
@@ -956,14 +2071,14 @@ void dev::CpuI8080::INRMem()
 	}
 }
 
-void dev::CpuI8080::DCR(uint8_t& _regDest)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::DCR(uint8_t& _regDest)
 {
 	switch (MC) {
 	case 0:
 		TMP = _regDest;
 		TMP--;
-		FAC = !((TMP & 0xF) == 0xF);
-		SetZSP(TMP);
+		SetZSPAC(TMP, (TMP & 0xF) != 0xF);
 		return;
 	case 1:
 		_regDest = TMP;
@@ -971,7 +2086,8 @@ void dev::CpuI8080::DCR(uint8_t& _regDest)
 	}
 }
 
-void dev::CpuI8080::DCRMem()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::DCRMem()
 {
 	switch (MC) {
 	case 0:
@@ -979,8 +2095,7 @@ void dev::CpuI8080::DCRMem()
 	case 1:
 		TMP = ReadByte(HL);
 		TMP--;
-		FAC = !((TMP & 0xF) == 0xF);
-		SetZSP(TMP);
+		SetZSPAC(TMP, (TMP & 0xF) != 0xF);
 		return;
 	case 2:
 		WriteByte(HL, TMP, Memory::AddrSpace::RAM, 0);
@@ -988,7 +2103,8 @@ void dev::CpuI8080::DCRMem()
 	}
 }
 
-void dev::CpuI8080::INX(uint16_t& _regPair)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::INX(uint16_t& _regPair)
 {
 	switch (MC) {
 	case 0:
@@ -1000,7 +2116,8 @@ void dev::CpuI8080::INX(uint16_t& _regPair)
 	}
 }
 
-void dev::CpuI8080::DCX(uint16_t& _regPair)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::DCX(uint16_t& _regPair)
 {
 	switch (MC) {
 	case 0:
@@ -1035,7 +2152,7 @@ void dev::CpuI8080::DAA()
 	}
 
 	ADD(A, correction, false);
-	FC = cy;
+	SET_FC(cy);
 }
 
 void dev::CpuI8080::ANA(uint8_t _sss)
@@ -1043,12 +2160,11 @@ void dev::CpuI8080::ANA(uint8_t _sss)
 	ACT = A;
 	TMP = _sss;
 	A = (uint8_t)(ACT & TMP);
-	FC = false;
-	FAC = ((ACT | TMP) & 0x08) != 0;
-	SetZSP(A);
+	F = (F & FLAGS_UNUSED) | zspTable[A] | ((ACT | TMP) & 0x08 ? FLAG_AC : 0);
 }
 
-void dev::CpuI8080::AMAMem()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::AMAMem()
 {
 	switch (MC) {
 	case 0:
@@ -1057,14 +2173,13 @@ void dev::CpuI8080::AMAMem()
 	case 1:
 		TMP = ReadByte(HL);
 		A = (uint8_t)(ACT & TMP);
-		FC = false;
-		FAC = ((ACT | TMP) & 0x08) != 0;
-		SetZSP(A);
+		F = (F & FLAGS_UNUSED) | zspTable[A] | ((ACT | TMP) & 0x08 ? FLAG_AC : 0);
 		return;
 	}
 }
 
-void dev::CpuI8080::ANI()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ANI()
 {
 	switch (MC) {
 	case 0:
@@ -1073,9 +2188,7 @@ void dev::CpuI8080::ANI()
 	case 1:
 		TMP = ReadInstrMovePC(1);
 		A = (uint8_t)(ACT & TMP);
-		FC = false;
-		FAC = ((ACT | TMP) & 0x08) != 0;
-		SetZSP(A);
+		F = (F & FLAGS_UNUSED) | zspTable[A] | ((ACT | TMP) & 0x08 ? FLAG_AC : 0);
 		return;
 	}
 }
@@ -1087,12 +2200,11 @@ void dev::CpuI8080::XRA(uint8_t _sss)
 	ACT = A;
 	TMP = _sss;
 	A = (uint8_t)(ACT ^ TMP);
-	FC = false;
-	FAC = false;
-	SetZSP(A);
+	F = (F & FLAGS_UNUSED) | zspTable[A];
 }
 
-void dev::CpuI8080::XRAMem()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::XRAMem()
 {
 	switch (MC) {
 	case 0:
@@ -1101,14 +2213,13 @@ void dev::CpuI8080::XRAMem()
 	case 1:
 		TMP = ReadByte(HL);
 		A = (uint8_t)(ACT ^ TMP);
-		FC = false;
-		FAC = false;
-		SetZSP(A);
+		F = (F & FLAGS_UNUSED) | zspTable[A];
 		return;
 	}
 }
 
-void dev::CpuI8080::XRI()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::XRI()
 {
 	switch (MC) {
 	case 0:
@@ -1117,9 +2228,7 @@ void dev::CpuI8080::XRI()
 	case 1:
 		TMP = ReadInstrMovePC(1);
 		A = (uint8_t)(ACT ^ TMP);
-		FC = false;
-		FAC = false;
-		SetZSP(A);
+		F = (F & FLAGS_UNUSED) | zspTable[A];
 		return;
 	}
 }
@@ -1131,12 +2240,11 @@ void dev::CpuI8080::ORA(uint8_t _sss)
 	ACT = A;
 	TMP = _sss;
 	A = (uint8_t)(ACT | TMP);
-	FC = false;
-	FAC = false;
-	SetZSP(A);
+	F = (F & FLAGS_UNUSED) | zspTable[A];
 }
 
-void dev::CpuI8080::ORAMem()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ORAMem()
 {
 	switch (MC) {
 	case 0:
@@ -1145,14 +2253,13 @@ void dev::CpuI8080::ORAMem()
 	case 1:
 		TMP = ReadByte(HL);
 		A = (uint8_t)(ACT | TMP);
-		FC = false;
-		FAC = false;
-		SetZSP(A);
+		F = (F & FLAGS_UNUSED) | zspTable[A];
 		return;
 	}
 }
 
-void dev::CpuI8080::ORI()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::ORI()
 {
 	switch (MC) {
 	case 0:
@@ -1161,9 +2268,7 @@ void dev::CpuI8080::ORI()
 	case 1:
 		TMP = ReadInstrMovePC(1);
 		A = (uint8_t)(ACT | TMP);
-		FC = false;
-		FAC = false;
-		SetZSP(A);
+		F = (F & FLAGS_UNUSED) | zspTable[A];
 		return;
 	}
 }
@@ -1173,46 +2278,39 @@ void dev::CpuI8080::CMP(uint8_t _sss)
 {
 	ACT = A;
 	TMP = _sss;
-	auto res = ACT - TMP;
-	FC = res & 0x100;
-	FAC = (~(ACT ^ (res & 0xFF) ^ TMP) & 0x10) == 0x10;
-	SetZSP((uint8_t)(res & 0xFF));
+	// the flags of the addition of the two's complement, the carry is inverted to get a borrow
+	uint8_t res = (uint8_t)(ACT - TMP);
+	F = (F & FLAGS_UNUSED) | zspTable[res] | (carryTable[GetCarryIdx(ACT, (uint8_t)(~TMP), res)] ^ FLAG_C);
 }
 
-void dev::CpuI8080::CMPMem()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::CMPMem()
 {
 	switch (MC) {
 	case 0:
 		ACT = A;
 		return;
-	case 1: {
-			TMP = ReadByte(HL);
-			int res = ACT - TMP;
-			FC = res & 0x100;
-			FAC = (~(ACT ^ (res & 0xFF) ^ TMP) & 0x10) == 0x10;
-			SetZSP((uint8_t)(res & 0xFF));
-			return;
-		}
+	case 1:
+		CMP(ReadByte(HL));
+		return;
 	}
 }
 
-void dev::CpuI8080::CPI()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::CPI()
 {
 	switch (MC) {
 	case 0:
 		ACT = A;
 		return;
 	case 1:
-		TMP = ReadInstrMovePC(1);
-		auto res = ACT - TMP;
-		FC = res & 0x100;
-		FAC = (~(ACT ^ (res & 0xFF) ^ TMP) & 0x10) == 0x10;
-		SetZSP((uint8_t)(res));
+		CMP(ReadInstrMovePC(1));
 		return;
 	}
 }
 
-void dev::CpuI8080::JMP(bool _condition)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::JMP(bool _condition)
 {
 	switch (MC) {
 	case 0:
@@ -1230,7 +2328,8 @@ void dev::CpuI8080::JMP(bool _condition)
 	}
 }
 
-void dev::CpuI8080::PCHL()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::PCHL()
 {
 	switch (MC) {
 	case 0:
@@ -1242,7 +2341,8 @@ void dev::CpuI8080::PCHL()
 }
 
 // pushes the current pc to the stack, then jumps to an address
-void dev::CpuI8080::CALL(bool _condition)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::CALL(bool _condition)
 {
 	switch (MC) {
 	case 0:
@@ -1273,7 +2373,8 @@ void dev::CpuI8080::CALL(bool _condition)
 }
 
 // pushes the current pc to the stack, then jumps to an address
-void dev::CpuI8080::RST(uint8_t _arg)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::RST(uint8_t _arg)
 {
 	switch (MC) {
 	case 0:
@@ -1295,7 +2396,8 @@ void dev::CpuI8080::RST(uint8_t _arg)
 }
 
 // returns from subroutine
-void dev::CpuI8080::RET()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::RET()
 {
 	switch (MC) {
 	case 0:
@@ -1313,7 +2415,8 @@ void dev::CpuI8080::RET()
 }
 
 // returns from subroutine if a condition is met
-void dev::CpuI8080::RETCond(bool _condition)
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::RETCond(bool _condition)
 {
 	switch (MC) {
 	case 0:
@@ -1333,7 +2436,8 @@ void dev::CpuI8080::RETCond(bool _condition)
 	}
 }
 
-void dev::CpuI8080::IN_()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::IN_()
 {
 	switch (MC) {
 	case 0:
@@ -1343,12 +2447,13 @@ void dev::CpuI8080::IN_()
 		Z = ReadInstrMovePC(1);
 		return;
 	case 2:
-		A = Input(Z);
+		A = m_bus.PortIn(Z);
 		return;
 	}
 }
 
-void dev::CpuI8080::OUT_()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::OUT_()
 {
 	switch (MC) {
 	case 0:
@@ -1358,12 +2463,13 @@ void dev::CpuI8080::OUT_()
 		Z = ReadInstrMovePC(1);
 		return;
 	case 2:
-		Output(Z, A);
+		m_bus.PortOut(Z, A);
 		return;
 	}
 }
 
-void dev::CpuI8080::HLT()
+template <class Bus>
+void dev::CpuI8080Bound<Bus>::HLT()
 {
 	switch (MC) {
 	case 0:
@@ -1379,4 +2485,11 @@ void dev::CpuI8080::HLT()
 		}
 		return;
 	}
-}
\ No newline at end of file
+}
+
+// the buses the cpu is bound to. the runtime-bound one is compiled only
+// for the tools that define DEV_CPU_FUNC_BUS
+template class dev::CpuI8080Bound<dev::HardwareBus>;
+#ifdef DEV_CPU_FUNC_BUS
+template class dev::CpuI8080Bound<dev::CpuI8080FuncBus>;
+#endif
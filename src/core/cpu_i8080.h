@@ -13,6 +13,8 @@
 #pragma once
 
 #include <functional>
+#include <array>
+#include <vector>
 #include <atomic>
 #include <mutex>
 
@@ -31,6 +33,8 @@ namespace dev
 		static const constexpr uint8_t OPCODE_PCHL = 0xE9;
 
 		static const constexpr int CLOCK = 3000000;
+		// a number of clock cycles one machine cycle takes
+		static const constexpr uint64_t MACHINE_CC = 4;
 
 		////////////////////////////////////////////////////////////////////////////
 		//
@@ -99,7 +103,9 @@ namespace dev
 		};
 #pragma pack(pop)
 
-		// defines the machine state
+		// defines the machine state. it is the serialization format for the
+		// debugger, the recorder, and the .rec file. the cpu runs on the
+		// LiveState and packs it into the State on request
 #pragma pack(push, 1)
 		struct State {
 			uint64_t cc; // clock cycles, debug related data
@@ -108,10 +114,13 @@ namespace dev
 		};
 #pragma pack(pop)
 
-		State state;
-
-		auto GetState() const -> const State& { return state; }
-		auto GetStateP() -> State* { return &state; }
+		auto GetState() const -> State;
+		// returns the State packed by the last PackState call
+		auto GetStateP() -> State* { return &m_state; }
+		// copies the live state into the State before the debugger or the recorder reads it
+		void PackState();
+		// applies the State changed by the debugger or the recorder back to the live state
+		void UnpackState();
 		uint64_t GetCC() const;
 		uint16_t GetPC() const;
 		uint16_t GetSP() const;
@@ -140,25 +149,95 @@ namespace dev
 		// memory + io interface
 		using InputFunc = std::function <uint8_t(const uint8_t _port)>;
 		using OutputFunc = std::function <void(const uint8_t _port, const uint8_t _value)>;
-
-		CpuI8080() = delete;
-		CpuI8080(
-			Memory& _memory,
-			InputFunc _input,
-			OutputFunc _output);
+		// machine cycle boundaries. the begin func returns the irq line state
+		using BeginMachineCycleFunc = std::function <bool()>;
+		using EndMachineCycleFunc = std::function <void()>;
 
 		void Init();
 		void Reset();
-		void ExecuteMachineCycle(bool _irq);
 		bool IsInstructionExecuted() const;
 
 		static auto GetInstrCC(const uint8_t _opcode) -> uint8_t;
 
+	protected:
+
+		// the execution state. the fields are naturally aligned and fit one cache line
+		struct alignas(64) LiveState {
+			uint64_t cc; // clock cycles
+			RegPair pc; // program counter
+			RegPair sp; // stack pointer
+			RegPair psw; // accumulator & flags
+			RegPair bc; // register pair BC
+			RegPair de; // register pair DE
+			RegPair hl; // register pair HL
+			RegPair wz; // temporary address reg
+			uint8_t ir; // internal register to fetch instructions
+			uint8_t tmp; // temporary register
+			uint8_t act; // temporary accumulator
+			uint8_t mc; // machine cycle index of the currently executed instruction
+			bool inte; // set if an iterrupt enabled
+			bool iff; // set by the 50 Hz interruption timer
+			bool hlta; // indicates that HLT instruction is executed
+			bool eiPending; // if set, the interruption call is pending until the next instruction
+		};
+
+		LiveState m_live;
+		State m_state;
+
+		CpuI8080();
+
+		////////////////////////////////////////////////////////////////////////////
+		//
+		// Instruction helpers
+		//
+		////////////////////////////////////////////////////////////////////////////
+
+		void SetZSPAC(uint8_t _val, bool _ac);
+		void RLC();
+		void RRC();
+		void RAL();
+		void RAR();
+		void XCHG();
+		void ADD(uint8_t _a, uint8_t _b, bool _cy);
+		void SUB(uint8_t _a, uint8_t _b, bool _cy);
+		void DAA();
+		void ANA(uint8_t _sss);
+		void XRA(uint8_t _sss);
+		void ORA(uint8_t _sss);
+		void CMP(uint8_t _sss);
+	};
+
+	// The cpu bound to the bus at compile time, so the memory and port access
+	// is inlined into the instruction handlers. The bus provides:
+	// 	CpuReadInstr, CpuRead, CpuWrite: the memory access templated on the debug policy, see Memory
+	// 	PortIn, PortOut: the port access, see IO
+	// 	BeginMachineCycle: called at the start of every machine cycle, returns the irq line state
+	// 	EndMachineCycle: called at the end of every machine cycle
+	// 	IdleMachineCycles: advances the machine cycles the halted cpu idles through
+	// 	GetMemory: the memory the instructions are fetched from, see FetchCachedInstr
+	template <class Bus>
+	class CpuI8080Bound : public CpuI8080
+	{
+	public:
+		CpuI8080Bound() = delete;
+		CpuI8080Bound(const Bus& _bus);
+
+		void ExecuteMachineCycle(bool _irq);
+		void ExecuteInstruction();
+		bool ExecuteHalted(const uint64_t _ccEvent);
+		bool IsHLTLoop() const;
+		// the memory debug bookkeeping is required by the debugger only
+		void SetMemoryDebug(const bool _memoryDebug);
+
 	private:
 
-		Memory& m_memory;
-		InputFunc Input;
-		OutputFunc Output;
+		Bus m_bus;
+		bool m_memoryDebug = true;
+
+		template <bool DEBUG>
+		void ExecuteInstr();
+		template <bool DEBUG>
+		void ExecuteHLTLoop();
 
 		void Decode();
 
@@ -168,25 +247,21 @@ namespace dev
 		//
 		////////////////////////////////////////////////////////////////////////////
 
+		template <bool DEBUG = true>
 		inline uint8_t ReadInstrMovePC(uint8_t _byteNum);
+		template <bool DEBUG = true>
 		inline uint8_t ReadByte(const Addr _addr, 
 			Memory::AddrSpace _addrSpace = Memory::AddrSpace::RAM, const uint8_t _byteNum = 0);
+		template <bool DEBUG = true>
 		inline void WriteByte(const Addr _addr, uint8_t _value,
 			Memory::AddrSpace _addrSpace, const uint8_t _byteNum);
 
 		////////////////////////////////////////////////////////////////////////////
 		//
-		// Instruction helpers
+		// Machine cycle handlers
 		//
 		////////////////////////////////////////////////////////////////////////////
 
-		bool GetParity(uint8_t _val);
-		bool GetCarry(int _bit_no, uint8_t _a, uint8_t _b, bool _cy);
-		void SetZSP(uint8_t _val);
-		void RLC();
-		void RRC();
-		void RAL();
-		void RAR();
 		void MOVRegReg(uint8_t& _regDest, uint8_t _regSrc);
 		void LoadRegPtr(uint8_t& _regDest, Addr _addr);
 		void MOVMemReg(uint8_t _sss);
@@ -199,14 +274,11 @@ namespace dev
 		void LHLD();
 		void SHLD();
 		void SPHL();
-		void XCHG();
 		void XTHL();
 		void PUSH(uint8_t _hb, uint8_t _lb);
 		void POP(uint8_t& _regH, uint8_t& _regL);
-		void ADD(uint8_t _a, uint8_t _b, bool _cy);
 		void ADDMem(bool _cy);
 		void ADI(bool _cy);
-		void SUB(uint8_t _a, uint8_t _b, bool _cy);
 		void SUBMem(bool _cy);
 		void SBI(bool _cy);
 		void DAD(RegPair _val);
@@ -216,17 +288,12 @@ namespace dev
 		void DCRMem();
 		void INX(uint16_t& _regPair);
 		void DCX(uint16_t& _regPair);
-		void DAA();
-		void ANA(uint8_t _sss);
 		void AMAMem();
 		void ANI();
-		void XRA(uint8_t _sss);
 		void XRAMem();
 		void XRI();
-		void ORA(uint8_t _sss);
 		void ORAMem();
 		void ORI();
-		void CMP(uint8_t _sss);
 		void CMPMem();
 		void CPI();
 		void JMP(bool _condition = true);
@@ -239,5 +306,180 @@ namespace dev
 		void OUT_();
 		void HLT();
 
+		////////////////////////////////////////////////////////////////////////////
+		//
+		// Instruction-granular execution
+		//
+		////////////////////////////////////////////////////////////////////////////
+
+		struct PredecodedInstr;
+		using ExecFunc = void (CpuI8080Bound::*)(const PredecodedInstr& _instr);
+
+		// operands are resolved once, so the handler runs the whole instruction
+		struct PredecodedInstr {
+			ExecFunc exec = nullptr;
+			uint8_t* reg1 = nullptr; // destination reg or a high byte of a pair
+			uint8_t* reg2 = nullptr; // source reg or a low byte of a pair
+			RegPair* regPair = nullptr;
+			// the condition of jumps, calls, returns, or a carry-in of ADC, SBB, ACI, SBI
+			uint8_t flagMask = 0;
+			uint8_t flagValue = 0;
+		};
+		std::array<PredecodedInstr, 256> m_predecoded;
+
+		// the instruction decoded at its address. the non-debug execution takes
+		// the handler, the opcode, and the operands from here instead of the memory.
+		// the machine cycles are still counted by the handler, so every machine
+		// cycle boundary reaches the bus
+		struct CachedInstr {
+			const PredecodedInstr* instr = nullptr;
+			uint8_t bytes[3] = { 0, 0, 0 };
+			uint8_t len = 0;
+		};
+		// the instructions up to the first jump, call, return, rst, or hlt, keyed
+		// by the global addr. a block never crosses a page of the cpu address space,
+		// so its bytes follow each other in the global memory, and it spans two
+		// code lines at most. it is valid while these code lines are not written and
+		// the memory mapping is not changed, see Memory::GetCodeGen
+		static constexpr int BLOCK_INSTRS_MAX = 16;
+		static constexpr int BLOCK_BYTES_MAX = Memory::CODE_LINE_LEN;
+		struct Block {
+			GlobalAddr globalAddr = UINT32_MAX;
+			GlobalAddr lastGlobalAddr = UINT32_MAX; // the last byte of the last instruction
+			uint64_t codeGen = 0;
+			uint32_t lineGens[2] = { 0, 0 }; // the generations of the first and the last code lines
+			uint64_t codeUpdates = 0; // the memory code updates it was checked at
+			uint8_t len = 0;
+			std::array<CachedInstr, BLOCK_INSTRS_MAX> instrs;
+		};
+		static constexpr int BLOCK_CACHE_LEN = 4096; // must be a power of two
+		std::vector<Block> m_blocks;
+		Block* m_block = nullptr;	// the running block
+		int m_blockInstrIdx = 0;	// the next instruction of the running block
+		Addr m_blockNextPC = 0;		// the addr of the next instruction of the running block
+		CachedInstr m_uncachedInstr; // the instruction crossing the page
+		const uint8_t* m_instrBytes = nullptr; // the bytes of the executed instruction
+
+		inline auto FetchCachedInstr() -> const CachedInstr&;
+		auto LookupCachedInstr() -> const CachedInstr&;
+		void DecodeBlock(Block& _block, const GlobalAddr _globalAddr);
+		inline bool IsBlockValid(Block& _block);
+
+		template <bool DEBUG>
+		void InitPredecoded();
+		inline void NextMachineCycle();
+		inline bool CheckCondition(const PredecodedInstr& _instr);
+
+		void ExecNOP(const PredecodedInstr& _instr);
+		void ExecMOVRegReg(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecLoadRegPtr(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecMOVMemReg(const PredecodedInstr& _instr);
+		void ExecMOVMemL(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecMVIRegData(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecMVIMemData(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecLDA(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecSTA(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecSTAX(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecLXI(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecLHLD(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecSHLD(const PredecodedInstr& _instr);
+		void ExecSPHL(const PredecodedInstr& _instr);
+		void ExecXCHG(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecXTHL(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecPUSH(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecPOP(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecPOPPSW(const PredecodedInstr& _instr);
+		void ExecADD(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecADDMem(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecADI(const PredecodedInstr& _instr);
+		void ExecSUB(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecSUBMem(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecSBI(const PredecodedInstr& _instr);
+		void ExecDAD(const PredecodedInstr& _instr);
+		void ExecINR(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecINRMem(const PredecodedInstr& _instr);
+		void ExecDCR(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecDCRMem(const PredecodedInstr& _instr);
+		void ExecINX(const PredecodedInstr& _instr);
+		void ExecDCX(const PredecodedInstr& _instr);
+		void ExecDAA(const PredecodedInstr& _instr);
+		void ExecCMA(const PredecodedInstr& _instr);
+		void ExecSTC(const PredecodedInstr& _instr);
+		void ExecCMC(const PredecodedInstr& _instr);
+		void ExecRLC(const PredecodedInstr& _instr);
+		void ExecRRC(const PredecodedInstr& _instr);
+		void ExecRAL(const PredecodedInstr& _instr);
+		void ExecRAR(const PredecodedInstr& _instr);
+		void ExecANA(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecANAMem(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecANI(const PredecodedInstr& _instr);
+		void ExecXRA(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecXRAMem(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecXRI(const PredecodedInstr& _instr);
+		void ExecORA(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecORAMem(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecORI(const PredecodedInstr& _instr);
+		void ExecCMP(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecCMPMem(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecCPI(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecJMP(const PredecodedInstr& _instr);
+		void ExecPCHL(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecCALL(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecRST(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecRET(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecRETCond(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecIN(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecOUT(const PredecodedInstr& _instr);
+		void ExecDI(const PredecodedInstr& _instr);
+		void ExecEI(const PredecodedInstr& _instr);
+		template <bool DEBUG> void ExecHLT(const PredecodedInstr& _instr);
 	};
+
+	// The bus bound at runtime with callbacks for tools that can't provide a static one
+	class CpuI8080FuncBus
+	{
+	public:
+		CpuI8080FuncBus(
+			Memory& _memory,
+			CpuI8080::InputFunc _input,
+			CpuI8080::OutputFunc _output,
+			CpuI8080::BeginMachineCycleFunc _beginMachineCycle,
+			CpuI8080::EndMachineCycleFunc _endMachineCycle)
+			:
+			m_memory(_memory), Input(_input), Output(_output),
+			BeginMachineCycleF(_beginMachineCycle), EndMachineCycleF(_endMachineCycle)
+		{}
+
+		template <bool DEBUG>
+		inline auto CpuReadInstr(const Addr _addr, const Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
+			-> uint8_t { return m_memory.CpuReadInstr<DEBUG>(_addr, _addrSpace, _byteNum); }
+		template <bool DEBUG>
+		inline auto CpuRead(const Addr _addr, const Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
+			-> uint8_t { return m_memory.CpuRead<DEBUG>(_addr, _addrSpace, _byteNum); }
+		template <bool DEBUG>
+		inline void CpuWrite(const Addr _addr, uint8_t _value, const Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
+			{ m_memory.CpuWrite<DEBUG>(_addr, _value, _addrSpace, _byteNum); }
+		inline auto PortIn(const uint8_t _port) -> uint8_t { return Input(_port); }
+		inline void PortOut(const uint8_t _port, const uint8_t _value) { Output(_port, _value); }
+		inline bool BeginMachineCycle() { return BeginMachineCycleF(); }
+		inline void EndMachineCycle() { EndMachineCycleF(); }
+		inline auto GetMemory() -> Memory& { return m_memory; }
+		// the caller bounds the idle cycles by the irq, so its line state is not checked
+		inline void IdleMachineCycles(const int _machineCycles)
+		{
+			for (int i = 0; i < _machineCycles; i++) {
+				BeginMachineCycleF();
+				EndMachineCycleF();
+			}
+		}
+
+	private:
+		Memory& m_memory;
+		CpuI8080::InputFunc Input;
+		CpuI8080::OutputFunc Output;
+		CpuI8080::BeginMachineCycleFunc BeginMachineCycleF;
+		CpuI8080::EndMachineCycleFunc EndMachineCycleF;
+	};
+
+	using CpuI8080Func = CpuI8080Bound<CpuI8080FuncBus>;
 }
\ No newline at end of file
@@ -13,11 +13,13 @@ dev::Debugger::Debugger(Hardware& _hardware)
 	m_hardware(_hardware),
 	m_lastReadsAddrs(), m_lastWritesAddrs(),
 	m_memLastRW(),
-	m_lastReadsAddrsOld(), m_lastWritesAddrsOld(), 
+	m_lastReadsAddrsOut(), m_lastWritesAddrsOut(),
 	m_debugData(_hardware), m_disasm(_hardware, m_debugData),
-	m_traceLog(m_debugData),
-	m_lastRWAddrsOut()
+	m_traceLog(m_debugData)
 {
+	m_lastReadsAddrsOut.fill(uint32_t(LAST_RW_NO_DATA));
+	m_lastWritesAddrsOut.fill(uint32_t(LAST_RW_NO_DATA));
+	m_memLastRW.reserve(LAST_RW_MAX * 2);
 
 	Hardware::DebugFunc debugFunc = std::bind(&Debugger::Debug, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
 
@@ -46,7 +48,6 @@ void dev::Debugger::Reset(bool _resetRecorder,
 	m_lastReadsAddrs.fill(uint32_t(LAST_RW_NO_DATA));
 	m_lastWritesIdx = 0;
 	m_lastReadsIdx = 0;
-	m_memLastRW.fill(0);
 
 	m_traceLog.Reset();
 	if (_resetRecorder) m_recorder.Reset(_cpuStateP, _memStateP, _ioStateP, _displayStateP);
@@ -356,42 +357,37 @@ void dev::Debugger::UpdateDisasm(const Addr _addr, const size_t _linesNum, const
 // UI thread
 void dev::Debugger::UpdateLastRW()
 {
-	// remove old stats
-	for (int i = 0; i < m_lastReadsAddrsOld.size(); i++)
+	// copy the circular buffers starting from the least recent access,
+	// so the index of an element is the order of the access
 	{
-		auto globalAddrLastRead = m_lastReadsAddrsOld[i];
-		if (globalAddrLastRead != LAST_RW_NO_DATA) {
-			m_memLastRW[globalAddrLastRead] = 0;
-		}
-		auto globalAddrLastWrite = m_lastWritesAddrsOld[i];
-		if (globalAddrLastWrite != LAST_RW_NO_DATA) {
-			m_memLastRW[globalAddrLastWrite] = 0;
-		}
-	}
-
-	// copy new reads stats
-	std::lock_guard<std::mutex> mlock(m_lastRWMutex);
-	uint16_t readsIdx = m_lastReadsIdx;
-	for (auto globalAddr : m_lastReadsAddrs){
-		if (globalAddr != LAST_RW_NO_DATA) 
+		std::lock_guard<std::mutex> mlock(m_lastRWMutex);
+		for (int i = 0; i < LAST_RW_MAX; i++)
 		{
-			auto val = m_memLastRW[globalAddr] & 0xFFFF0000; // remove reads, keep writes
-			m_memLastRW[globalAddr] = val | static_cast<uint16_t>(LAST_RW_MAX - readsIdx) % LAST_RW_MAX;
+			m_lastReadsAddrsOut[i] = m_lastReadsAddrs[(m_lastReadsIdx + i) % LAST_RW_MAX];
+			m_lastWritesAddrsOut[i] = m_lastWritesAddrs[(m_lastWritesIdx + i) % LAST_RW_MAX];
 		}
-		readsIdx--;
 	}
 
-	// copy new writes stats
-	uint16_t writesIdx = m_lastWritesIdx;
-	for (auto globalAddr : m_lastWritesAddrs){
-		if (globalAddr != LAST_RW_NO_DATA) 
-		{
-			auto val = m_memLastRW[globalAddr] & 0x0000FFFF; // remove writes, keep reads
-			m_memLastRW[globalAddr] = val | (static_cast<uint16_t>(LAST_RW_MAX - writesIdx) % LAST_RW_MAX)<<16;
+	m_memLastRW.clear();
+	for (int i = 0; i < LAST_RW_MAX; i++)
+	{
+		auto globalAddr = m_lastReadsAddrsOut[i];
+		if (globalAddr != LAST_RW_NO_DATA) {
+			auto& val = m_memLastRW[globalAddr];
+			val = (val & 0xFFFF0000) | i; // replace reads, keep writes
+		}
+		globalAddr = m_lastWritesAddrsOut[i];
+		if (globalAddr != LAST_RW_NO_DATA) {
+			auto& val = m_memLastRW[globalAddr];
+			val = (val & 0x0000FFFF) | i << 16; // replace writes, keep reads
 		}
-		writesIdx--;
 	}
-	
-	m_lastReadsAddrsOld = m_lastReadsAddrs;
-	m_lastWritesAddrsOld = m_lastWritesAddrs;
+}
+
+// UI thread
+auto dev::Debugger::GetLastRW(const GlobalAddr _globalAddr) const
+-> uint32_t
+{
+	auto it = m_memLastRW.find(_globalAddr);
+	return it == m_memLastRW.end() ? 0 : it->second;
 }
\ No newline at end of file
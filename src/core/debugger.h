@@ -26,8 +26,9 @@ namespace dev
 		static constexpr int LAST_RW_H = 32;
 		static constexpr int LAST_RW_MAX = LAST_RW_W * LAST_RW_H; // should be squared because it is sent to GPU
 		static constexpr uint32_t LAST_RW_NO_DATA = uint32_t(-1);
-		using MemLastRW = std::array<uint32_t, Memory::MEMORY_GLOBAL_LEN>;
 		using LastRWAddrs = std::array<uint32_t, LAST_RW_MAX>;
+		// globalAddr -> the order of the last access. low 2 bytes - reads, high 2 bytes - writes
+		using MemLastRW = std::unordered_map<GlobalAddr, uint32_t>;
 
 		Debugger(Hardware& _hardware);
 		~Debugger();
@@ -43,7 +44,9 @@ namespace dev
 			IO::State* _ioStateP, Display::State* _displayStateP) -> nlohmann::json;
 
 		void UpdateLastRW();
-		auto GetLastRW() -> const MemLastRW* { return &m_memLastRW; }
+		auto GetLastRW(const GlobalAddr _globalAddr) const -> uint32_t;
+		auto GetLastReads() const -> const LastRWAddrs* { return &m_lastReadsAddrsOut; }
+		auto GetLastWrites() const -> const LastRWAddrs* { return &m_lastWritesAddrsOut; }
 		void UpdateDisasm(const Addr _addr, const size_t _lines, const int _instructionOffset);
 		auto GetTraceLog() -> TraceLog& { return m_traceLog; };
 		auto GetDebugData() -> DebugData& { return m_debugData; };
@@ -61,12 +64,12 @@ namespace dev
 		std::mutex m_lastRWMutex;
 		LastRWAddrs m_lastReadsAddrs; // a circular buffer that contains addresses
 		LastRWAddrs m_lastWritesAddrs; // ...
-		LastRWAddrs m_lastReadsAddrsOld; // ... used to clean up m_memLastReads
-		LastRWAddrs m_lastWritesAddrsOld; // ... ...
-		LastRWAddrs m_lastRWAddrsOut; // used to sent the data out of this thread
+		LastRWAddrs m_lastReadsAddrsOut; // a copy of m_lastReadsAddrs for the UI thread. the least recently read comes first
+		LastRWAddrs m_lastWritesAddrsOut; // ...
 		int m_lastReadsIdx = 0; // index to m_memLastReads, points to the least recently read. because it's a circular buffer, that element before it is the most recently read
 		int m_lastWritesIdx = 0; // ...
-		MemLastRW m_memLastRW; // low 2 bytes of each element contains the order of readings. 255 is the most recently read, 0 - the least recently read
-								// high 2 bytes contains the order of writings. 255 is the most recently written, 0 - the least recently written
+		MemLastRW m_memLastRW; // low 2 bytes of each element contains the order of readings. LAST_RW_MAX-1 is the most recently read, 0 - the least recently read
+								// high 2 bytes contains the order of writings. LAST_RW_MAX-1 is the most recently written, 0 - the least recently written
+								// it holds only the addresses from m_lastReadsAddrsOut and m_lastWritesAddrsOut
 	};
 }
\ No newline at end of file
@@ -1,8 +1,76 @@
+#include <algorithm>
+#include <cstring>
+
 #include "core/display.h"
 #include "utils/utils.h"
 
+// the column kernels shuffle the palette colors with SSSE3 on x64. the kernel is
+// compiled for SSSE3 regardless of the build flags and picked by the cpu check
+// at runtime. other targets and cpus use the scalar kernels
+#if defined(__x86_64__) || defined(_M_X64)
+#include <tmmintrin.h>
+#define DISPLAY_SSSE3
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define DISPLAY_SSSE3_TARGET __attribute__((target("ssse3")))
+#else
+#define DISPLAY_SSSE3_TARGET
+#endif
+#endif
+
 #define BORDER_RIGHT	( m_borderLeft + ACTIVE_AREA_W )
 
+// spreads the 4-bit color idxs of a screen column into the bytes of the result,
+// the nibble 0 goes to the byte 0
+static inline uint64_t NibblesToBytes(const uint32_t _colorIdxs)
+{
+	uint64_t bytes = _colorIdxs;
+	bytes = (bytes | bytes << 16) & 0x0000FFFF0000FFFF;
+	bytes = (bytes | bytes << 8) & 0x00FF00FF00FF00FF;
+	bytes = (bytes | bytes << 4) & 0x0F0F0F0F0F0F0F0F;
+	return bytes;
+}
+
+#ifdef DISPLAY_SSSE3
+static bool IsSsse3Supported()
+{
+#if defined(__SSSE3__)
+	return true;
+#elif defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+	return (cpuInfo[2] & (1 << 9)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static const bool SSSE3_SUPPORTED = IsSsse3Supported();
+
+// shuffles the palette colors of the column pxls [_pxlOffset, _pxlOffset + _pxls) into the frame buffer
+DISPLAY_SSSE3_TARGET
+static void FillColumnSsse3(uint8_t* _frameBufferP, const uint8_t* _palette,
+	const uint64_t _colorIdxsEven, const uint64_t _colorIdxsOdd, const int _pxlOffset, const int _pxls)
+{
+	__m128i pxlColorIdxs = _mm_unpacklo_epi8(
+		_mm_cvtsi64_si128((int64_t)_colorIdxsEven), _mm_cvtsi64_si128((int64_t)_colorIdxsOdd));
+	__m128i colors = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)_palette), pxlColorIdxs);
+
+	if (_pxls == dev::Display::RASTERIZED_PXLS_MAX)
+	{
+		_mm_storeu_si128((__m128i*)_frameBufferP, colors);
+	}
+	else {
+		alignas(16) uint8_t colorsBytes[dev::Display::RASTERIZED_PXLS_MAX];
+		_mm_store_si128((__m128i*)colorsBytes, colors);
+		std::memcpy(_frameBufferP, colorsBytes + _pxlOffset, _pxls);
+	}
+}
+#endif
+
 dev::Display::Display(Memory& _memory, IO& _io)
 	:
 	m_memory(_memory), m_io(_io)
@@ -11,7 +79,8 @@ dev::Display::Display(Memory& _memory, IO& _io)
 	for (int i = 0; i < FULL_PALLETE_LEN; i++) {
 		m_state.update.fullPallete[i] = VectorColorToArgb(i);
 	}
-	m_state.frameBufferP = &m_frameBuffer;
+	m_frameBufferP = &m_buffers[m_drawIdx];
+	m_state.frameBufferP = m_frameBufferP;
 
 	m_state.BuffUpdate = std::bind(&Display::BuffUpdate, this, std::placeholders::_1);
 
@@ -21,7 +90,13 @@ dev::Display::Display(Memory& _memory, IO& _io)
 void dev::Display::Init()
 {
 	m_state.update.framebufferIdx = 0;
-	m_frameBuffer.fill(0xff000000);
+	m_deferredIdx = 0;
+	for (auto& buffer : m_buffers) buffer.fill(0);
+	SetContentUpdated();
+
+	m_skipRaster = m_gpuDecode || m_fastForward;
+	m_skipRenderedIdx = 0;
+	m_frameDisplayUpdates = m_io.GetDisplayUpdates();
 }
 
 void dev::Display::RasterizeActiveArea(const int _rasterizedPixels)
@@ -42,12 +117,15 @@ void dev::Display::RasterizeActiveArea(const int _rasterizedPixels)
 	}
 }
 
+// the pixels are handled one by one only if the span contains an event:
+// a pending port commit, the interrupt request, or the end of the frame
 void dev::Display::RasterizeBorder(const int _rasterizedPixels)
 {
-	int rasterLine = GetRasterLine();
-	auto commitTime = m_io.GetOutCommitTimer() >= 0 || m_io.GetPaletteCommitTimer() >= 0;
+	int framebufferIdxEnd = m_state.update.framebufferIdx + _rasterizedPixels;
+	bool irqTime = m_state.update.framebufferIdx < m_irqCommitPxl && m_irqCommitPxl <= framebufferIdxEnd;
+	bool frameEnd = framebufferIdxEnd >= FRAME_LEN;
 
-	if (commitTime || rasterLine == 0 || rasterLine == 311)
+	if (m_io.IsCommitPending() || irqTime || frameEnd)
 	{
 		FillBorderPortHandling(_rasterizedPixels);
 	}
@@ -56,12 +134,165 @@ void dev::Display::RasterizeBorder(const int _rasterizedPixels)
 	}
 }
 
-// renders 16 pixels (in the 512 mode) from left to right
+// advances the raster by 16 pixels (in the 512 mode).
+// the span is rendered immediately only if it contains an event: a pending port commit,
+// the scroll commit line, the interrupt request, or the end of the frame. otherwise
+// the pixels are deferred and rendered in one batch at the end of the scanline,
+// or earlier if the screen memory they show is about to change.
+// the gpu decode skips rendering the deferred pixels unless the display ports are about to change,
+// the fast-forward skips them regardless
 void dev::Display::Rasterize()
 {
 	// reset the interrupt request. it can be set during border drawing.
 	m_state.update.irq = false;
 
+	int framebufferIdxEnd = m_state.update.framebufferIdx + RASTERIZED_PXLS_MAX;
+	bool irqTime = m_state.update.framebufferIdx < m_irqCommitPxl && m_irqCommitPxl <= framebufferIdxEnd;
+	bool frameEnd = framebufferIdxEnd >= FRAME_LEN;
+	bool scrollTime = GetRasterLine() == SCAN_ACTIVE_AREA_TOP;
+
+	if (m_io.IsCommitPending() || irqTime || frameEnd || scrollTime)
+	{
+		// the scroll latched mid-frame is not in the screen memory copy
+		if (m_skipRaster && !m_fastForward && scrollTime && m_io.GetScroll() != m_state.update.scrollIdx) StopSkipRaster();
+
+		if (m_skipRaster) RasterizeSkipped();
+		else RasterizeDeferred();
+
+		RasterizeSpan();
+		m_deferredIdx = m_state.update.framebufferIdx;
+
+		if (m_skipRaster && !m_fastForward && m_io.GetDisplayUpdates() != m_frameDisplayUpdates) StopSkipRaster();
+		return;
+	}
+
+	m_state.update.framebufferIdx = framebufferIdxEnd;
+	if (framebufferIdxEnd % FRAME_W == 0) RasterizeDeferred();
+}
+
+// rasterizes the spans with no events in one go, the same way as Rasterize
+// does it span by span. the caller bounds them by the next event, see Scheduler
+void dev::Display::RasterizeIdle(const int _spans)
+{
+	m_state.update.irq = false;
+
+	int framebufferIdxEnd = m_state.update.framebufferIdx + _spans * RASTERIZED_PXLS_MAX;
+
+	// the deferred pixels are rendered at the end of every scanline
+	for (int lineEndIdx = (GetRasterLine() + 1) * FRAME_W;
+		lineEndIdx <= framebufferIdxEnd;
+		lineEndIdx += FRAME_W)
+	{
+		m_state.update.framebufferIdx = lineEndIdx;
+		RasterizeDeferred();
+	}
+
+	m_state.update.framebufferIdx = framebufferIdxEnd;
+}
+
+// renders the pixels skipped by Rasterize. the ports, the palette, and the scroll
+// stay unchanged over them, and they never cross the end of the scanline
+void dev::Display::RasterizeDeferred()
+{
+	int framebufferIdxEnd = m_state.update.framebufferIdx;
+	if (m_skipRaster || m_deferredIdx >= framebufferIdxEnd) return;
+
+	m_state.update.framebufferIdx = m_deferredIdx;
+
+	int rasterLine = GetRasterLine();
+	bool isActiveScan = rasterLine >= SCAN_ACTIVE_AREA_TOP && rasterLine < SCAN_ACTIVE_AREA_TOP + ACTIVE_AREA_H;
+
+	if (isActiveScan)
+	{
+		int lineStartIdx = rasterLine * FRAME_W;
+		int activeAreaIdx = dev::Min(lineStartIdx + m_borderLeft, framebufferIdxEnd);
+		int borderRightIdx = dev::Min(lineStartIdx + BORDER_RIGHT, framebufferIdxEnd);
+
+		if (m_state.update.framebufferIdx < activeAreaIdx) {
+			FillBorder(activeAreaIdx - m_state.update.framebufferIdx);
+		}
+
+		if (m_state.update.framebufferIdx < borderRightIdx)
+		{
+			bool mode512 = m_io.GetDisplayMode() == IO::MODE_512;
+			// the 256 mode spans starting on an odd pxl are rendered one by one to match FillActiveArea256
+			if (mode512 || m_borderLeft % 2 == 0)
+			{
+				FillActiveAreaColumns(borderRightIdx - m_state.update.framebufferIdx, mode512);
+			}
+			else {
+				while (m_state.update.framebufferIdx < borderRightIdx)
+				{
+					int spanEndIdx = (m_state.update.framebufferIdx / RASTERIZED_PXLS_MAX + 1) * RASTERIZED_PXLS_MAX;
+					FillActiveArea256(dev::Min(spanEndIdx, borderRightIdx) - m_state.update.framebufferIdx);
+				}
+			}
+		}
+	}
+
+	if (m_state.update.framebufferIdx < framebufferIdxEnd) {
+		FillBorder(framebufferIdxEnd - m_state.update.framebufferIdx);
+	}
+
+	m_deferredIdx = framebufferIdxEnd;
+}
+
+// renders the skipped pixels before the display ports commit with the current ports.
+// the span of the commit is rendered by the caller
+void dev::Display::RasterizeSkipped()
+{
+	if (m_fastForward || !m_io.IsDisplayCommitPending()) return;
+
+	FillRange(m_skipRenderedIdx, m_state.update.framebufferIdx);
+	m_skipRenderedIdx = m_state.update.framebufferIdx + RASTERIZED_PXLS_MAX;
+}
+
+// renders the skipped pixels and switches the rest of the frame to the regular rasterization
+void dev::Display::StopSkipRaster()
+{
+	if (!m_skipRaster) return;
+
+	FillRange(m_skipRenderedIdx, m_state.update.framebufferIdx);
+	m_skipRaster = false;
+	m_deferredIdx = m_state.update.framebufferIdx;
+}
+
+// the gpu decode is expected to be enabled only while the emulation runs.
+// disabling it renders the pixels skipped in the current frame
+void dev::Display::SetGpuDecode(const bool _gpuDecode)
+{
+	m_gpuDecode = _gpuDecode;
+	if (!m_gpuDecode) StopSkipRaster();
+}
+
+// the fast-forward frames show the screen memory at the end of the frame with the display ports
+// set by then. the emulation stays exact, only the pixel rendering is skipped.
+// disabling it renders the pixels skipped in the current frame
+void dev::Display::SetFastForward(const bool _fastForward)
+{
+	m_fastForward = _fastForward;
+	if (!m_fastForward) StopSkipRaster();
+}
+
+// renders the deferred pixels if the cpu is going to overwrite the screen bytes of their scanline
+void dev::Display::VramWrite(const GlobalAddr _globalAddr)
+{
+	if (m_skipRaster || m_deferredIdx == m_state.update.framebufferIdx ||
+		_globalAddr < 0x8000 || _globalAddr >= Memory::MEMORY_MAIN_LEN) return;
+
+	int rasterLine = m_deferredIdx / FRAME_W;
+	if (rasterLine < SCAN_ACTIVE_AREA_TOP || rasterLine >= SCAN_ACTIVE_AREA_TOP + ACTIVE_AREA_H) return;
+
+	int rasterLineScrolled = (rasterLine - SCAN_ACTIVE_AREA_TOP + (255 - m_state.update.scrollIdx) + ACTIVE_AREA_H) % ACTIVE_AREA_H + SCAN_ACTIVE_AREA_TOP;
+	auto addrLow = ACTIVE_AREA_H - 1 - (rasterLineScrolled - SCAN_ACTIVE_AREA_TOP);
+
+	if ((_globalAddr & 0xff) == (GlobalAddr)addrLow) RasterizeDeferred();
+}
+
+// renders 16 pixels (in the 512 mode) from left to right handling the port commits,
+// the scroll, and the interrupt request
+void dev::Display::RasterizeSpan()
+{
 	int rasterLine = GetRasterLine();
 	int rasterPixel = GetRasterPixel();
 	
@@ -99,11 +330,9 @@ void dev::Display::Rasterize()
 
 void dev::Display::FillBorder(const int _rasterizedPixels)
 {
-	auto borderColor = m_state.update.fullPallete[m_io.GetBorderColor()];
-	for (int i = 0; i < _rasterizedPixels; i++)
-	{
-		m_frameBuffer[m_state.update.framebufferIdx++] = borderColor;
-	}
+	auto borderColor = m_io.GetBorderColor();
+	std::fill_n(m_frameBufferP->data() + m_state.update.framebufferIdx, _rasterizedPixels, borderColor);
+	m_state.update.framebufferIdx += _rasterizedPixels;
 }
 
 void dev::Display::FillBorderPortHandling(const int _rasterizedPixels)
@@ -111,9 +340,9 @@ void dev::Display::FillBorderPortHandling(const int _rasterizedPixels)
 	for (int i = 0; i < _rasterizedPixels; i++)
 	{
 		m_io.TryToCommit(m_io.GetBorderColorIdx());
-		auto color = m_state.update.fullPallete[m_io.GetBorderColor()];
+		auto color = m_io.GetBorderColor();
 
-		m_frameBuffer[m_state.update.framebufferIdx++] = color;
+		(*m_frameBufferP)[m_state.update.framebufferIdx++] = color;
 		int isNewFrame = m_state.update.framebufferIdx / FRAME_LEN;
 		m_state.update.framebufferIdx %= FRAME_LEN;
 
@@ -124,34 +353,40 @@ void dev::Display::FillBorderPortHandling(const int _rasterizedPixels)
 		if (isNewFrame)
 		{
 			m_state.update.frameNum++;
-			std::unique_lock<std::mutex> mlock(m_backBufferMutex);
-			m_backBuffer = m_frameBuffer; // copy a frame to a back buffer
+			SwapBuffers();
 		}
 	}
 }
 
 void dev::Display::FillActiveArea256(const int _rasterizedPixels)
 {
+	// the column kernel keeps the pxl pairs of the 256 mode only if the span starts on an even pxl
+	if ((m_state.update.framebufferIdx - m_borderLeft) % 2 == 0)
+	{
+		FillActiveAreaColumns(_rasterizedPixels, false);
+		return;
+	}
+
 	// scrolling
 	int rasterLine = GetRasterLine();
 	int rasterPixel = GetRasterPixel();
 	int rasterLineScrolled = (rasterLine - SCAN_ACTIVE_AREA_TOP + (255 - m_state.update.scrollIdx) + ACTIVE_AREA_H) % ACTIVE_AREA_H + SCAN_ACTIVE_AREA_TOP;
 
 	// rasterization
-	auto screenBytes = GetScreenBytes(rasterLineScrolled, rasterPixel);
+	auto colorIdxs = GetScreenColorIdxs(rasterLineScrolled, rasterPixel);
 	int bitIdx = 7 - (((m_state.update.framebufferIdx - m_borderLeft) % RASTERIZED_PXLS_MAX) >> 1);
 
 	for (int i = 0; i < _rasterizedPixels; i++)
 	{
-		auto colorIdx = BytesToColorIdx256(screenBytes, bitIdx);
-		auto color = m_state.update.fullPallete[m_io.GetColor(colorIdx)];		
+		auto colorIdx = GetColorIdx256(colorIdxs, bitIdx);
+		auto color = m_io.GetColor(colorIdx);
 		
-		m_frameBuffer[m_state.update.framebufferIdx++] = color;
+		(*m_frameBufferP)[m_state.update.framebufferIdx++] = color;
 
 		bitIdx -= i % 2;
 		if (bitIdx < 0) {
 			bitIdx = 7;
-			screenBytes = GetScreenBytes(rasterLineScrolled, GetRasterPixel());
+			colorIdxs = GetScreenColorIdxs(rasterLineScrolled, GetRasterPixel());
 		}
 	}
 }
@@ -164,7 +399,7 @@ void dev::Display::FillActiveArea256PortHandling(const int _rasterizedPixels)
 	int rasterLineScrolled = (rasterLine - SCAN_ACTIVE_AREA_TOP + (255 - m_state.update.scrollIdx) + ACTIVE_AREA_H) % ACTIVE_AREA_H + SCAN_ACTIVE_AREA_TOP;
 
 	// rasterization
-	auto screenBytes = GetScreenBytes(rasterLineScrolled, rasterPixel);
+	auto colorIdxs = GetScreenColorIdxs(rasterLineScrolled, rasterPixel);
 	int bitIdx = 7 - (((m_state.update.framebufferIdx - m_borderLeft) % RASTERIZED_PXLS_MAX) >> 1);
 
 	for (int i = 0; i < _rasterizedPixels; i++)
@@ -175,16 +410,16 @@ void dev::Display::FillActiveArea256PortHandling(const int _rasterizedPixels)
 			m_state.update.scrollIdx = m_io.GetScroll();
 		}
 
-		auto colorIdx = BytesToColorIdx256(screenBytes, bitIdx);
+		auto colorIdx = GetColorIdx256(colorIdxs, bitIdx);
 		m_io.TryToCommit(colorIdx);
-		auto color = m_state.update.fullPallete[m_io.GetColor(colorIdx)];
+		auto color = m_io.GetColor(colorIdx);
 
-		m_frameBuffer[m_state.update.framebufferIdx++] = color;
+		(*m_frameBufferP)[m_state.update.framebufferIdx++] = color;
 
 		bitIdx -= i % 2;
 		if (bitIdx < 0){
 			bitIdx = 7;
-			screenBytes = GetScreenBytes(rasterLineScrolled, rasterPixel);
+			colorIdxs = GetScreenColorIdxs(rasterLineScrolled, rasterPixel);
 		}
 	}
 }
@@ -197,7 +432,7 @@ void dev::Display::FillActiveArea512PortHandling(const int _rasterizedPixels)
 	int rasterLineScrolled = (rasterLine - SCAN_ACTIVE_AREA_TOP + (255 - m_state.update.scrollIdx) + ACTIVE_AREA_H) % ACTIVE_AREA_H + SCAN_ACTIVE_AREA_TOP;
 
 	// rasterization
-	auto screenBytes = GetScreenBytes(rasterLineScrolled, rasterPixel); // 4 bytes. One byte per screen buffer
+	auto colorIdxs = GetScreenColorIdxs(rasterLineScrolled, rasterPixel); // 8 color idxs, 4 bits each
 	int pxlIdx = 15 - ((m_state.update.framebufferIdx - m_borderLeft) % RASTERIZED_PXLS_MAX); // 0-15
 
 	for (int i = 0; i < _rasterizedPixels; i++)
@@ -208,57 +443,278 @@ void dev::Display::FillActiveArea512PortHandling(const int _rasterizedPixels)
 			m_state.update.scrollIdx = m_io.GetScroll();
 		}
 
-		auto colorIdx = BytesToColorIdx512(screenBytes, pxlIdx);
+		auto colorIdx = GetColorIdx512(colorIdxs, pxlIdx);
 		m_io.TryToCommit(colorIdx);
-		auto color = m_state.update.fullPallete[m_io.GetColor(colorIdx)];
+		auto color = m_io.GetColor(colorIdx);
 
-		m_frameBuffer[m_state.update.framebufferIdx++] = color;
+		(*m_frameBufferP)[m_state.update.framebufferIdx++] = color;
 
 		pxlIdx--;
 		if (pxlIdx < 0){
 			pxlIdx = 15;
-			screenBytes = GetScreenBytes(rasterLineScrolled, rasterPixel);
+			colorIdxs = GetScreenColorIdxs(rasterLineScrolled, rasterPixel);
 		}		
 	}
 }
 
 void dev::Display::FillActiveArea512(const int _rasterizedPixels)
+{
+	FillActiveAreaColumns(_rasterizedPixels, true);
+}
+
+// rasterizes the active area without the port handling. every 16 pxls
+// column is expanded from its four screen bytes at once
+void dev::Display::FillActiveAreaColumns(const int _rasterizedPixels, const bool _mode512)
 {
 	// scrolling
 	int rasterLine = GetRasterLine();
-	int rasterPixel = GetRasterPixel();
 	int rasterLineScrolled = (rasterLine - SCAN_ACTIVE_AREA_TOP + (255 - m_state.update.scrollIdx) + ACTIVE_AREA_H) % ACTIVE_AREA_H + SCAN_ACTIVE_AREA_TOP;
-	
-	// rasterization
-	auto screenBytes = GetScreenBytes(rasterLineScrolled, rasterPixel); // 4 bytes. One byte per screen buffer
-	int pxlIdx = 15 - ((m_state.update.framebufferIdx - m_borderLeft) % RASTERIZED_PXLS_MAX); // 0-15
 
-	for (int i = 0; i < _rasterizedPixels; i++)
+	int pxlOffset = (m_state.update.framebufferIdx - m_borderLeft) % RASTERIZED_PXLS_MAX;
+
+	for (int pxlsLeft = _rasterizedPixels; pxlsLeft > 0;)
 	{
-		auto colorIdx = BytesToColorIdx512(screenBytes, pxlIdx);
-		auto color = m_state.update.fullPallete[m_io.GetColor(colorIdx)];
-		
-		m_frameBuffer[m_state.update.framebufferIdx++] = color;
-		
-		pxlIdx--;
-		if (pxlIdx < 0){
-			pxlIdx = 15;
-			screenBytes = GetScreenBytes(rasterLineScrolled, GetRasterPixel());
-		}
+		auto colorIdxs = GetScreenColorIdxs(rasterLineScrolled, GetRasterPixel());
+		int pxls = dev::Min(RASTERIZED_PXLS_MAX - pxlOffset, pxlsLeft);
+
+		FillColumn(colorIdxs, _mode512, pxlOffset, pxls);
+
+		pxlsLeft -= pxls;
+		pxlOffset = 0;
+	}
+}
+
+// expands the color idxs of the screen column into the colors of the column pxls [_pxlOffset, _pxlOffset + _pxls)
+// In the 512 mode, the even pxls get the colors from the screen buffers 3 and 2 (the bits 0-1 of a color idx),
+// the odd ones - from the screen buffers 0 and 1 (the bits 2-3). In the 256 mode, every pxl is doubled
+void dev::Display::FillColumn(const uint32_t _colorIdxs, const bool _mode512, const int _pxlOffset, const int _pxls)
+{
+	// 8 color idxs, one per byte. the 512 mode has them split into the even and odd pxls
+	uint64_t colorIdxs = NibblesToBytes(_colorIdxs);
+	uint64_t colorIdxsEven = _mode512 ? colorIdxs & 0x0303030303030303 : colorIdxs;
+	uint64_t colorIdxsOdd = _mode512 ? colorIdxs & 0x0C0C0C0C0C0C0C0C : colorIdxs;
+
+	uint8_t* frameBufferP = m_frameBufferP->data() + m_state.update.framebufferIdx;
+	m_state.update.framebufferIdx += _pxls;
+
+	auto paletteP = m_io.GetPalette();
+
+#ifdef DISPLAY_SSSE3
+	if (SSSE3_SUPPORTED)
+	{
+		FillColumnSsse3(frameBufferP, paletteP->bytes, colorIdxsEven, colorIdxsOdd, _pxlOffset, _pxls);
+		return;
+	}
+#endif
+	for (int pxl = _pxlOffset; pxl < _pxlOffset + _pxls; pxl++)
+	{
+		auto pxlColorIdxs = pxl & 1 ? colorIdxsOdd : colorIdxsEven;
+		*frameBufferP++ = paletteP->bytes[(pxlColorIdxs >> ((pxl >> 1) * 8)) & 0xf];
 	}
 }
 
 bool dev::Display::IsIRQ() { return m_state.update.irq; }
 
-auto dev::Display::GetFrame(const bool _vsync)
+// the events are rasterized by the span starting before them. the spans are
+// counted the same way as Rasterize checks them, the cycles wrap to the next frame
+auto dev::Display::GetCcToIrq() const
+-> int
+{
+	int pxls = (m_irqCommitPxl - m_state.update.framebufferIdx - 1 + FRAME_LEN) % FRAME_LEN;
+	return pxls / RASTERIZED_PXLS_MAX * RASTERIZED_PXLS_MAX / PXLS_PER_CC;
+}
+
+auto dev::Display::GetCcToFrameEnd() const
+-> int
+{
+	int pxls = FRAME_LEN - RASTERIZED_PXLS_MAX - m_state.update.framebufferIdx;
+	int spans = pxls <= 0 ? 0 : (pxls + RASTERIZED_PXLS_MAX - 1) / RASTERIZED_PXLS_MAX;
+	return spans * RASTERIZED_PXLS_MAX / PXLS_PER_CC;
+}
+
+auto dev::Display::GetCcToScroll() const
+-> int
+{
+	constexpr int scrollLineIdx = SCAN_ACTIVE_AREA_TOP * FRAME_W;
+	if (GetRasterLine() == SCAN_ACTIVE_AREA_TOP) return 0;
+
+	int pxls = (scrollLineIdx - m_state.update.framebufferIdx + FRAME_LEN) % FRAME_LEN;
+	int spans = (pxls + RASTERIZED_PXLS_MAX - 1) / RASTERIZED_PXLS_MAX;
+	return spans * RASTERIZED_PXLS_MAX / PXLS_PER_CC;
+}
+
+// hands the completed frame over to the ui thread and takes the buffer
+// the ui is done with to draw the next frame. it never waits for the ui
+void dev::Display::SwapBuffers()
+{
+	// the frame with the display ports changed is rendered on the cpu
+	if (m_skipRaster && !m_fastForward && m_io.GetDisplayUpdates() != m_frameDisplayUpdates)
+	{
+		FillRange(m_skipRenderedIdx, FRAME_LEN);
+		m_skipRaster = false;
+	}
+
+	m_bufferVramOnly[m_drawIdx] = m_skipRaster;
+	if (m_skipRaster)
+	{
+		auto& vramFrame = m_vramFrames[m_drawIdx];
+		std::memcpy(vramFrame.vram.data(), m_memory.GetRam()->data() + Memory::MEMORY_MAIN_LEN - SCREEN_LEN, SCREEN_LEN);
+		std::memcpy(vramFrame.palette, m_io.GetPalette()->bytes, IO::PALETTE_LEN);
+		vramFrame.scrollIdx = m_state.update.scrollIdx;
+		vramFrame.borderColorIdx = m_io.GetBorderColorIdx();
+		vramFrame.mode512 = m_io.GetDisplayMode() == IO::MODE_512;
+		vramFrame.borderLeft = m_borderLeft;
+	}
+
+	auto displayUpdates = m_memory.GetScreenUpdates() + m_io.GetDisplayUpdates();
+	if (displayUpdates != m_displayUpdatesLast)
+	{
+		m_displayUpdatesLast = displayUpdates;
+		// the frame after the update can differ from this one too
+		m_updatedFrames = 2;
+	}
+	if (m_updatedFrames > 0)
+	{
+		m_updatedFrames--;
+		m_contentId++;
+	}
+
+	m_bufferContentIds[m_drawIdx] = m_contentId;
+	m_bufferFrameNums[m_drawIdx] = m_state.update.frameNum;
+	m_drawIdx = m_readyIdx.exchange(m_drawIdx | BUFFER_FRESH) & BUFFER_IDX_MASK;
+
+	m_frameBufferP = &m_buffers[m_drawIdx];
+	m_state.frameBufferP = m_frameBufferP;
+
+	m_skipRaster = m_gpuDecode || m_fastForward;
+	m_skipRenderedIdx = 0;
+	m_frameDisplayUpdates = m_io.GetDisplayUpdates();
+}
+
+// the frame being drawn was changed bypassing the rasterization or the rasterization settings changed
+void dev::Display::SetContentUpdated()
+{
+	m_updatedFrames = 2;
+	m_contentId++;
+}
+
+// outputs the frame in ABGR colors.
+// UI thread. only one thread can read the frames
+auto dev::Display::GetFrame(const bool _vsync, uint64_t* const _frameNumP,
+	uint64_t* const _contentIdP)
 ->const FrameBuffer*
 {
-	std::unique_lock<std::mutex> mlock(m_backBufferMutex);
-	m_gpuBuffer = _vsync ? m_backBuffer : m_frameBuffer;
+	VectorToArgb(*GetVectorFrame(_vsync, _frameNumP, _contentIdP), m_gpuBuffer);
 
 	return &m_gpuBuffer;
 }
 
+// outputs the frame in Vector06c colors. it is four times smaller than the ABGR one,
+// the colors are expected to be converted by the gpu.
+// _vsync == true outputs the last completed frame, otherwise the frame being rasterized
+// is combined with the last completed one past the raster position.
+// _contentIdP gets the id which stays the same while the output frame is unchanged.
+// if _vramFramePP is set, and the completed frame was not rendered, it gets the screen memory copy
+// to decode the frame from, and the output buffer is not valid. otherwise the frame is decoded here.
+// UI thread. only one thread can read the frames
+auto dev::Display::GetVectorFrame(const bool _vsync, uint64_t* const _frameNumP,
+	uint64_t* const _contentIdP, const VramFrame** _vramFramePP)
+->const VectorFrameBuffer*
+{
+	if (m_readyIdx.load() & BUFFER_FRESH)
+	{
+		m_readIdx = m_readyIdx.exchange(m_readIdx) & BUFFER_IDX_MASK;
+	}
+	const VectorFrameBuffer* readBufferP = &m_buffers[m_readIdx];
+	bool vramOnly = m_bufferVramOnly[m_readIdx];
+
+	if (_vramFramePP) *_vramFramePP = nullptr;
+
+	if (_vsync)
+	{
+		if (_frameNumP) *_frameNumP = m_bufferFrameNums[m_readIdx];
+		if (_contentIdP) *_contentIdP = m_bufferContentIds[m_readIdx];
+
+		if (vramOnly && _vramFramePP) {
+			*_vramFramePP = &m_vramFrames[m_readIdx];
+		}
+		else if (vramOnly) {
+			VramFrameToVector(m_vramFrames[m_readIdx], m_gpuVectorBuffer);
+			readBufferP = &m_gpuVectorBuffer;
+		}
+		return readBufferP;
+	}
+
+	if (vramOnly) {
+		VramFrameToVector(m_vramFrames[m_readIdx], m_gpuVectorBuffer);
+		readBufferP = &m_gpuVectorBuffer;
+	}
+	const auto& readBuffer = *readBufferP;
+
+	int framebufferIdx = m_state.update.framebufferIdx;
+	const auto& drawBuffer = *m_state.frameBufferP;
+	std::copy(drawBuffer.begin(), drawBuffer.begin() + framebufferIdx, m_gpuVectorBuffer.begin());
+	if (!vramOnly) {
+		std::copy(readBuffer.begin() + framebufferIdx, readBuffer.end(), m_gpuVectorBuffer.begin() + framebufferIdx);
+	}
+
+	if (_frameNumP) *_frameNumP = m_state.update.frameNum;
+
+	// the combined frame changes with the raster position and the content of both buffers
+	std::array<uint64_t, 4> combinedFrameKey = { m_bufferContentIds[m_readIdx], m_contentId,
+		m_state.update.frameNum, uint64_t(framebufferIdx) << 32 | uint32_t(m_deferredIdx) };
+	if (combinedFrameKey != m_combinedFrameKey)
+	{
+		m_combinedFrameKey = combinedFrameKey;
+		m_combinedContentId++;
+	}
+	if (_contentIdP) *_contentIdP = m_combinedContentId;
+
+	return &m_gpuVectorBuffer;
+}
+
+// decodes the frame from the screen memory the same way the rasterizer does
+void dev::Display::VramFrameToVector(const VramFrame& _vramFrame, VectorFrameBuffer& _buffer)
+{
+	_buffer.fill(_vramFrame.palette[_vramFrame.borderColorIdx]);
+
+	for (int line = 0; line < ACTIVE_AREA_H; line++)
+	{
+		int lineScrolled = (line + (255 - _vramFrame.scrollIdx) + ACTIVE_AREA_H) % ACTIVE_AREA_H;
+		int addrLow = ACTIVE_AREA_H - 1 - lineScrolled;
+		uint8_t* pxlP = _buffer.data() + (SCAN_ACTIVE_AREA_TOP + line) * FRAME_W + _vramFrame.borderLeft;
+
+		for (int column = 0; column < ACTIVE_AREA_W / RASTERIZED_PXLS_MAX; column++)
+		{
+			const uint8_t* screenP = _vramFrame.vram.data() + (column << 8 | addrLow);
+
+			for (int pxl = 0; pxl < RASTERIZED_PXLS_MAX; pxl++)
+			{
+				// the buffer 0x8000 holds the bit 3 of the color idxs, the buffer 0xE000 - the bit 0
+				int bitIdx = 7 - (pxl >> 1);
+				int colorIdx =
+					(screenP[0] >> bitIdx & 1) << 3 |
+					(screenP[SCREEN_PLANE_LEN] >> bitIdx & 1) << 2 |
+					(screenP[SCREEN_PLANE_LEN * 2] >> bitIdx & 1) << 1 |
+					(screenP[SCREEN_PLANE_LEN * 3] >> bitIdx & 1);
+
+				// in the 512 mode, the even pxls use the bits 0-1, the odd ones - the bits 2-3
+				if (_vramFrame.mode512) colorIdx &= pxl & 1 ? 0xC : 0x3;
+
+				*pxlP++ = _vramFrame.palette[colorIdx];
+			}
+		}
+	}
+}
+
+void dev::Display::VectorToArgb(const VectorFrameBuffer& _vectorBuffer, FrameBuffer& _buffer) const
+{
+	for (int i = 0; i < FRAME_LEN; i++)
+	{
+		_buffer[i] = m_state.update.fullPallete[_vectorBuffer[i]];
+	}
+}
+
 // Vector color format: uint8_t BBGGGRRR
 // Output Color: ABGR (Imgui Image)
 auto dev::Display::VectorColorToArgb(const uint8_t _vColor)
@@ -277,48 +733,37 @@ auto dev::Display::VectorColorToArgb(const uint8_t _vColor)
 }
 
 /**
- * Retrieves four screen bytes at the current raster line and pixel.
- * Each byte for each graphic buffer.
+ * Retrieves the color idxs of the 8 pxls of the screen column at the current raster line and pixel.
+ * The left pxl is in the low nibble.
  */
-uint32_t dev::Display::GetScreenBytes(int _rasterLine, int _rasterPixel)
+uint32_t dev::Display::GetScreenColorIdxs(int _rasterLine, int _rasterPixel)
 {
 	auto addrHigh = (_rasterPixel - m_borderLeft) / RASTERIZED_PXLS_MAX;
 	auto addrLow = ACTIVE_AREA_H - 1 - (_rasterLine - SCAN_ACTIVE_AREA_TOP);
 	Addr screenAddrOffset = static_cast<Addr>(addrHigh << 8 | addrLow);
 
-	return m_memory.GetScreenBytes(screenAddrOffset);
+	return m_memory.GetScreenColorIdxs(screenAddrOffset);
 }
 
 // 256 screen mode
-// extract a 4-bit color index from the four screen bytes.
-// _bitIdx is in the range [0..7]
-uint32_t dev::Display::BytesToColorIdx256(uint32_t _screenBytes, uint8_t _bitIdx)
+// extract a 4-bit color index from the screen column.
+// _bitIdx is in the range [0..7], the bit 7 is the left pxl
+uint32_t dev::Display::GetColorIdx256(uint32_t _colorIdxs, uint8_t _bitIdx)
 {
-	return (_screenBytes >> (_bitIdx - 0 + 0))  & 1 |
-		   (_screenBytes >> (_bitIdx - 1 + 8))  & 2 |
-		   (_screenBytes >> (_bitIdx - 2 + 16)) & 4 |
-		   (_screenBytes >> (_bitIdx - 3 + 24)) & 8;
+	return (_colorIdxs >> ((7 - _bitIdx) * 4)) & 0xf;
 }
 
 // 512 screen mode
-// extract a 3-bit color index from the four screen bytes.
+// extract a 3-bit color index from the screen column.
 // _bitIdx is in the range [0..15]
 // In the 512x256 mode, the even pixel colors are stored in screen buffers 3 and 2,
 // and the odd ones - in screen buffers 0 and 1
-uint32_t dev::Display::BytesToColorIdx512(uint32_t _screenBytes, uint8_t _bitIdx)
+uint32_t dev::Display::GetColorIdx512(uint32_t _colorIdxs, uint8_t _bitIdx)
 {
 	bool even = _bitIdx & 1;
-	_bitIdx >>= 1;
-	
-	if (even) {
-		return 
-			(_screenBytes >> (_bitIdx - 0 + 0)) & 1 |
-			(_screenBytes >> (_bitIdx - 1 + 8)) & 2;
-	}
+	auto colorIdx = (_colorIdxs >> ((7 - (_bitIdx >> 1)) * 4)) & 0xf;
 
-	return
-		((_screenBytes >> (_bitIdx - 0 + 16)) & 1 |
-		(_screenBytes >> (_bitIdx - 1 + 24)) & 2) * 4;
+	return even ? colorIdx & 0x3 : colorIdx & 0xc;
 }
 
 // rasterizes the memory into the frame buff
@@ -331,11 +776,19 @@ void dev::Display::BuffUpdate(Buffer _buffer)
 		break;
 
 	case dev::Display::Buffer::BACK_BUFFER:
-		m_backBuffer = m_frameBuffer;
+	{
+		// hands the frame over and keeps drawing it
+		auto& frameBuffer = *m_frameBufferP;
+		StopSkipRaster();
+		SetContentUpdated();
+		SwapBuffers();
+		*m_frameBufferP = frameBuffer;
+		m_skipRaster = false;
 		break;
+	}
 
 	case dev::Display::Buffer::GPU_BUFFER:
-		m_gpuBuffer = m_frameBuffer;
+		VectorToArgb(*m_frameBufferP, m_gpuBuffer);
 		break;
 
 	default:
@@ -344,11 +797,25 @@ void dev::Display::BuffUpdate(Buffer _buffer)
 }
 
 void dev::Display::FrameBuffUpdate()
+{
+	// the ram could be restored bypassing the memory writes
+	m_memory.UpdateScreenColumns();
+	m_memory.SetDirtyRows();
+	SetContentUpdated();
+
+	FillRange(0, FRAME_LEN);
+	m_deferredIdx = m_state.update.framebufferIdx;
+	m_skipRaster = false;
+}
+
+// renders the pixels [_framebufferIdxStart, _framebufferIdxEnd) of the current frame without the port handling.
+// the range starts at the beginning of a 16 pxls span
+void dev::Display::FillRange(const int _framebufferIdxStart, const int _framebufferIdxEnd)
 {
 	int framebufferIdxTemp = m_state.update.framebufferIdx;
-	m_state.update.framebufferIdx = 0;
+	m_state.update.framebufferIdx = _framebufferIdxStart;
 
-	for(int i=0; i < FRAME_LEN; i += 16)
+	while (m_state.update.framebufferIdx < _framebufferIdxEnd)
 	{
 		int rasterLine = GetRasterLine();
 		int rasterPixel = GetRasterPixel();
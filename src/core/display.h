@@ -3,7 +3,7 @@
 #include <vector>
 #include <array>
 #include <chrono>
-#include <mutex>
+#include <atomic>
 
 #include "utils/types.h"
 #include "core/memory.h"
@@ -50,6 +50,7 @@ namespace dev
 		static constexpr int BORDER_LEFT = 128;				// left border in pxls in MODE_512		
 		static constexpr int BORDER_VISIBLE = 16; // border visible on the screen in pxls in 256 mode
 		static constexpr int RASTERIZED_PXLS_MAX = 16;	// the amount of rasterized pxls every 4 cpu cycles in MODE_512
+		static constexpr int PXLS_PER_CC = 4;			// the amount of rasterized pxls every cpu cycle in MODE_512
 		static constexpr int COLORS_POLUTED_DELAY = 4; // this timer in pixels. if the palette is set inside the active area, the fourth and the fifth pixels get corrupted colors
 
 		static constexpr int IRQ_COMMIT_PXL = 112; // interrupt request. time's counted by 12 MHz clock (equals amount of pixels in 512 mode)
@@ -58,6 +59,22 @@ namespace dev
 		static constexpr int FULL_PALLETE_LEN = 256;
 
 		using FrameBuffer = std::array <ColorI, FRAME_LEN>;
+		using VectorFrameBuffer = std::array <uint8_t, FRAME_LEN>; // Vector06c color format : uint8_t BBGGGRRR
+
+		static constexpr int SCREEN_LEN = 0x8000; // the screen memory of the main ram 0x8000-0xFFFF
+		static constexpr int SCREEN_PLANE_LEN = SCREEN_LEN / 4;
+
+		// the frame left to be decoded from the screen memory. it is used if the palette,
+		// the display mode, the border color, and the scroll were not changed during the frame
+		struct VramFrame
+		{
+			std::array<uint8_t, SCREEN_LEN> vram;
+			uint8_t palette[IO::PALETTE_LEN];
+			uint8_t scrollIdx;
+			uint8_t borderColorIdx;
+			bool mode512;
+			int borderLeft;
+		};
 		
 		enum class Buffer { FRAME_BUFFER, BACK_BUFFER, GPU_BUFFER};
 		using BuffUpdateFunc = std::function<void(const Buffer _buffer)>;
@@ -77,7 +94,7 @@ namespace dev
 		struct State
 		{
 			Update update;
-			FrameBuffer* frameBufferP = nullptr;
+			VectorFrameBuffer* frameBufferP = nullptr;
 			BuffUpdateFunc BuffUpdate = nullptr;
 		};
 
@@ -87,20 +104,63 @@ namespace dev
 
 		State m_state;
 
-		FrameBuffer m_frameBuffer;	// rasterizer draws here
-		FrameBuffer m_backBuffer;	// a buffer to simulate VSYNC
-		FrameBuffer m_gpuBuffer;	// temp buffer for output to GPU
-		std::mutex m_backBufferMutex;
+		// triple buffering to simulate VSYNC. the rasterizer draws into m_buffers[m_drawIdx],
+		// the ui reads m_buffers[m_readIdx], m_readyIdx holds the last completed frame
+		// to be swapped by any side without waiting for the other
+		static constexpr int BUFFER_IDX_MASK = 0x3;
+		static constexpr int BUFFER_FRESH = 0x4; // the ready buffer was not read yet
+		std::array<VectorFrameBuffer, 3> m_buffers;
+		std::array<uint64_t, 3> m_bufferFrameNums = { 0, 0, 0 };
+		int m_drawIdx = 0;
+		std::atomic_int m_readyIdx = 1;
+		int m_readIdx = 2;
+		VectorFrameBuffer* m_frameBufferP = nullptr; // rasterizer draws here
+
+		// the frames with the same content id are identical. a frame gets a new id if
+		// the screen memory or the display ports changed during this or the previous frame
+		std::array<uint64_t, 3> m_bufferContentIds = { 0, 0, 0 };
+		uint64_t m_contentId = 0;
+		uint64_t m_displayUpdatesLast = 0; // the screen memory and the display ports updates at the last swap
+		int m_updatedFrames = 0; // the amount of next frames to get a new content id
+		// the ui side ids of the frames combined from the draw and the read buffers
+		static constexpr uint64_t CONTENT_ID_COMBINED = 1ull << 63;
+		std::array<uint64_t, 4> m_combinedFrameKey = {};
+		uint64_t m_combinedContentId = CONTENT_ID_COMBINED;
+
+		// the gpu decode skips the pixel rendering of a frame. the skipped pixels are rendered
+		// only before the display ports commit. if no display ports changed by the end of
+		// the frame, the frame is handed over as the screen memory copy
+		bool m_gpuDecode = false;
+		bool m_fastForward = false;			// every frame is handed over as the screen memory copy
+		bool m_skipRaster = false;			// the current frame pixels are not rendered
+		int m_skipRenderedIdx = 0;			// the skipped pixels of the current frame start here
+		uint64_t m_frameDisplayUpdates = 0;	// the display ports updates at the start of the frame
+		std::array<VramFrame, 3> m_vramFrames;
+		std::array<bool, 3> m_bufferVramOnly = { false, false, false }; // the buffer pxls are not rendered, m_vramFrames has the frame
+
+		FrameBuffer m_gpuBuffer;				// temp buffer for output to GPU
+		VectorFrameBuffer m_gpuVectorBuffer;	// temp buffer for output to GPU in Vector06c colors
 
 		int m_borderLeft = BORDER_LEFT;
 		int m_irqCommitPxl = IRQ_COMMIT_PXL;
+		// the pixels from m_deferredIdx up to the framebufferIdx are not rendered yet
+		int m_deferredIdx = 0;
 
 	public:
 		Display(Memory& _memory, IO& _io);
 		void Init();
 		void Rasterize();
+		void RasterizeDeferred();
+		void RasterizeIdle(const int _spans);
+		void VramWrite(const GlobalAddr _globalAddr);
 		bool IsIRQ();
-		auto GetFrame(const bool _vsync) ->const FrameBuffer*;
+		auto GetFrame(const bool _vsync, uint64_t* const _frameNumP = nullptr,
+			uint64_t* const _contentIdP = nullptr) ->const FrameBuffer*;
+		auto GetVectorFrame(const bool _vsync, uint64_t* const _frameNumP = nullptr,
+			uint64_t* const _contentIdP = nullptr, const VramFrame** _vramFramePP = nullptr) ->const VectorFrameBuffer*;
+		void SetGpuDecode(const bool _gpuDecode);
+		void SetFastForward(const bool _fastForward);
+		static void VramFrameToVector(const VramFrame& _vramFrame, VectorFrameBuffer& _buffer);
 		inline auto GetFrameNum() const -> uint64_t { return m_state.update.frameNum; };
 		inline int GetRasterLine() const { return m_state.update.framebufferIdx / FRAME_W; };
 		inline int GetRasterPixel() const { return m_state.update.framebufferIdx % FRAME_W; };
@@ -110,24 +170,37 @@ namespace dev
 		auto GetState() const -> const State& { return m_state; };
 		auto GetStateP() -> State* { return &m_state; };
 		auto GetBorderLeft() const -> int { return m_borderLeft; };
-		void SetBorderLeft(const int _borderLeft) { m_borderLeft = _borderLeft; };
+		void SetBorderLeft(const int _borderLeft) { m_borderLeft = _borderLeft; SetContentUpdated(); };
 		auto GetIrqCommitPxl() const -> int { return m_irqCommitPxl; };
-		void SetIrqCommitPxl(const int _irqCommitPxl) { m_irqCommitPxl = _irqCommitPxl; };
+		void SetIrqCommitPxl(const int _irqCommitPxl) { m_irqCommitPxl = _irqCommitPxl; SetContentUpdated(); };
+		void SetContentUpdated();
+		// the cpu cycles before the machine cycle rasterizing the event, see Scheduler
+		auto GetCcToIrq() const -> int;
+		auto GetCcToFrameEnd() const -> int;
+		auto GetCcToScroll() const -> int;
 
 	private:
 		uint32_t BytesToColorIdxs();
-		uint32_t GetScreenBytes(int _rasterLine, int _rasterPixel);
-		uint32_t BytesToColorIdx256(uint32_t _screenBytes, uint8_t _bitIdx);
-		uint32_t BytesToColorIdx512(uint32_t _screenBytes, uint8_t _bitIdx);
+		uint32_t GetScreenColorIdxs(int _rasterLine, int _rasterPixel);
+		uint32_t GetColorIdx256(uint32_t _colorIdxs, uint8_t _bitIdx);
+		uint32_t GetColorIdx512(uint32_t _colorIdxs, uint8_t _bitIdx);
+		void RasterizeSpan();
 		void RasterizeActiveArea(const int _rasterizedPixels);
 		void FillActiveArea256(const int _rasterizedPixels = RASTERIZED_PXLS_MAX);
 		void FillActiveArea512(const int _rasterizedPixels = RASTERIZED_PXLS_MAX);
 		void FillActiveArea256PortHandling(const int _rasterizedPixels = RASTERIZED_PXLS_MAX);
 		void FillActiveArea512PortHandling(const int _rasterizedPixels = RASTERIZED_PXLS_MAX);
+		void FillColumn(const uint32_t _colorIdxs, const bool _mode512, const int _pxlOffset, const int _pxls);
+		void FillActiveAreaColumns(const int _rasterizedPixels, const bool _mode512);
 		void RasterizeBorder(const int _rasterizedPixels);
 		void FillBorder(const int _rasterizedPixels = RASTERIZED_PXLS_MAX);
 		void FillBorderPortHandling(const int _rasterizedPixels = RASTERIZED_PXLS_MAX);
+		void FillRange(const int _framebufferIdxStart, const int _framebufferIdxEnd);
+		void RasterizeSkipped();
+		void StopSkipRaster();
 		void BuffUpdate(Buffer _buffer);
 		void FrameBuffUpdate();
+		void SwapBuffers();
+		void VectorToArgb(const VectorFrameBuffer& _vectorBuffer, FrameBuffer& _buffer) const;
 	};
 }
\ No newline at end of file
@@ -13,14 +13,13 @@ dev::Hardware::Hardware(const std::string& _pathBootData,
 	m_aywrapper(m_ay),
 	m_audio(m_timer, m_aywrapper),
 	m_fdc(),
-	m_io(m_keyboard, m_memory, m_timer, m_ay, m_fdc),
-	m_cpu(
-		m_memory,
-		std::bind(&IO::PortIn, &m_io, std::placeholders::_1),
-		std::bind(&IO::PortOut, &m_io, std::placeholders::_1, std::placeholders::_2)),
-	m_display(m_memory, m_io)
+	m_io(m_keyboard, m_memory, m_timer, m_aywrapper, m_fdc),
+	m_cpu(HardwareBus(m_memory, m_io, m_display, m_audio)),
+	m_display(m_memory, m_io),
+	m_pacer(Display::VSYC_DELAY)
 {
 	Init();
+	m_cpu.SetMemoryDebug(m_debugAttached);
 	m_executionThread = std::thread(&Hardware::Execution, this);
 }
 
@@ -49,19 +48,32 @@ void dev::Hardware::AttachDebugFuncs(DebugFunc _debugFunc, DebugReqHandlingFunc
 bool dev::Hardware::ExecuteInstruction()
 {
 	// mem debug init
-	m_memory.DebugInit();
+	if (m_debugAttached) m_memory.DebugInit();
 
-	do
+	// the halted cpu idles up to the next device event in one go, unless the debugger
+	// has to check every instruction
+	if (!m_debugAttached && m_cpu.IsHLTLoop())
 	{
-		m_display.Rasterize();
-		m_cpu.ExecuteMachineCycle(m_display.IsIRQ());
-		m_audio.Clock(2, m_io.GetBeeper());
-
-	} while (!m_cpu.IsInstructionExecuted());
+		ScheduleEvents();
+		m_cpu.ExecuteHalted(m_scheduler.GetNext());
+	}
+	else {
+		m_cpu.ExecuteInstruction();
+	}
 
 	// debug per instruction
-	if (m_debugAttached && Debug(m_cpu.GetStateP(), m_memory.GetStateP(), m_io.GetStateP(), m_display.GetStateP()) ) {
-		return true;
+	if (m_debugAttached)
+	{
+		m_cpu.PackState();
+		bool isBreak = Debug(m_cpu.GetStateP(), m_memory.GetStateP(), m_io.GetStateP(), m_display.GetStateP());
+
+		// the debugger reverts the writes to the read-only memory directly in the ram
+		auto& debug = m_memory.GetState().debug;
+		for (int i = 0; i < debug.writeLen; i++) {
+			m_memory.UpdateScreenColumn(debug.writeGlobalAddr[i]);
+		}
+
+		if (isBreak) return true;
 	}
 
 	if (m_memory.IsException())
@@ -75,6 +87,26 @@ bool dev::Hardware::ExecuteInstruction()
 	return false;
 }
 
+// the devices register the cycles of their next events
+void dev::Hardware::ScheduleEvents()
+{
+	auto cc = m_cpu.GetCC();
+
+	m_scheduler.Set(Scheduler::Event::IRQ, cc + m_display.GetCcToIrq());
+	m_scheduler.Set(Scheduler::Event::FRAME_END, cc + m_display.GetCcToFrameEnd());
+	m_scheduler.Set(Scheduler::Event::SCROLL, cc + m_display.GetCcToScroll());
+	// the commit timers count the pixels of the current machine cycle
+	m_scheduler.Set(Scheduler::Event::IO_COMMIT, m_io.IsCommitPending() ? cc : Scheduler::NEVER);
+
+	// the timer is clocked twice every machine cycle
+	int ticks = m_timer.GetTicksToEdge();
+	m_scheduler.Set(Scheduler::Event::TIMER, ticks == TimerI8253::NO_EDGE ? Scheduler::NEVER :
+		cc + (ticks > 0 ? (ticks - 1) / 2 * CpuI8080::MACHINE_CC : 0));
+
+	// the fdc is driven by the port access only. its m_wait watchdog counts the status reads
+	m_scheduler.Set(Scheduler::Event::FDC, Scheduler::NEVER);
+}
+
 // TODO:
 // 1. reload, reset, update the palette, and other non-hardware-initiated operations have to reset the playback history
 // 2. navigation. show data as data in the disasm. take the list from the watchpoints
@@ -86,9 +118,10 @@ void dev::Hardware::Execution()
 	{
 		auto startCC = m_cpu.GetCC();
 		auto startFrame = m_display.GetFrameNum();
-		auto startTime = std::chrono::system_clock::now();
+		auto startTime = std::chrono::steady_clock::now();
 
-		auto expectedTime = std::chrono::system_clock::now();
+		m_pacer.Reset();
+		bool audioPaced = false; // the last frame was paced by the audio playback
 
 		while (m_status == Status::RUN)
 		{   
@@ -104,14 +137,18 @@ void dev::Hardware::Execution()
 
 			} while (m_status == Status::RUN && m_display.GetFrameNum() == frameNum);
 
-			// vsync
-			if (m_status == Status::RUN)
+			// vsync. the max speed is not paced. the audio pacing falls back to
+			// the pacer if the playback does not consume the samples
+			if (m_status == Status::RUN && m_speedMul > 0.0)
 			{
-				expectedTime = expectedTime + m_execDelays[static_cast<int>(m_execSpeed)];
-
-				if (std::chrono::system_clock::now() < expectedTime){
-					std::this_thread::sleep_until(expectedTime);
+				bool paced = m_audioPacing && m_speedMul == 1.0 && m_audio.WaitBuffering();
+				// the pacer deadline is stale after the frames paced by the audio
+				if (paced != audioPaced)
+				{
+					audioPaced = paced;
+					m_pacer.Reset();
 				}
+				if (!paced) m_pacer.Wait();
 			}
 		}
 
@@ -119,7 +156,7 @@ void dev::Hardware::Execution()
 		auto elapsedCC = m_cpu.GetCC() - startCC;
 		if (elapsedCC) {
 			auto elapsedFrames = m_display.GetFrameNum() - startFrame;
-			std::chrono::duration<int64_t, std::nano> elapsedTime = std::chrono::system_clock::now() - startTime;
+			std::chrono::duration<int64_t, std::nano> elapsedTime = std::chrono::steady_clock::now() - startTime;
 			double timeDurationSec = elapsedTime.count() / 1000000000.0;
 			dev::Log("Break: elapsed cpu cycles: {}, elapsed frames: {}, elapsed seconds: {}", elapsedCC, elapsedFrames, timeDurationSec);
 		}
@@ -144,6 +181,9 @@ void dev::Hardware::ReqHandling(const bool _waitReq)
 {
 	if (!m_reqs.empty() || _waitReq)
 	{        
+		// the requests and the ui see the frame up to the current raster position
+		m_display.RasterizeDeferred();
+
 		auto result = m_reqs.pop();
 
 		const auto& [req, dataJ] = *result;
@@ -187,6 +227,10 @@ void dev::Hardware::ReqHandling(const bool _waitReq)
 			ExecuteFrameNoBreaks();
 			break;
 		}
+		case Req::EXECUTE_FRAMES:
+			out = ExecuteFrames(dataJ);
+			break;
+
 		case Req::GET_CC:
 			out = {
 				{"cc", m_cpu.GetCC() },
@@ -239,6 +283,7 @@ void dev::Hardware::ReqHandling(const bool _waitReq)
 		case Req::SET_IO_PALETTE_COMMIT_TIME:
 		{
 			m_io.SetPaletteCommitTime(dataJ["paletteCommitTime"]);
+			m_display.SetContentUpdated();
 			break;
 		}
 
@@ -272,6 +317,13 @@ void dev::Hardware::ReqHandling(const bool _waitReq)
 			break;
 		}
 
+		case Req::SET_DISPLAY_GPU_DECODE:
+		{
+			m_gpuDecode = dataJ["gpuDecode"];
+			m_display.SetGpuDecode(m_gpuDecode && m_status == Status::RUN);
+			break;
+		}
+
 		case Req::GET_IO_DISPLAY_MODE:
 			out = {
 				{"data", m_io.GetDisplayMode()},
@@ -410,11 +462,47 @@ void dev::Hardware::ReqHandling(const bool _waitReq)
 
 		case Req::SET_CPU_SPEED:
 		{
-			int speed = dataJ["speed"];
-			speed = std::clamp(speed, 0, int(sizeof(m_execDelays) - 1));
-			m_execSpeed = static_cast<ExecSpeed>(speed);
-			if (m_execSpeed == ExecSpeed::_20PERCENT) { m_audio.Mute(true); }
-			else { m_audio.Mute(false); }
+			// either the ExecSpeed or any multiplier of the frame rate
+			if (dataJ.contains("speedMul")) {
+				SetSpeed(dataJ["speedMul"]);
+			}
+			else {
+				int speed = dataJ["speed"];
+				speed = std::clamp(speed, 0, int(ExecSpeed::LEN) - 1);
+				SetSpeed(m_execSpeedMuls[speed]);
+			}
+			break;
+		}
+
+		case Req::SET_AUDIO_PACING:
+		{
+			m_audioPacing = dataJ["audioPacing"];
+			m_audio.SetAudioPacing(m_audioPacing && m_speedMul == 1.0);
+			m_pacer.Reset();
+			break;
+		}
+
+		case Req::SET_AUDIO_OUTPUT_RATE:
+		{
+			int outputRate = dataJ["outputRate"];
+			m_audio.SetOutputRate(outputRate == 44100 ? 44100 : 48000);
+			break;
+		}
+
+		case Req::GET_PACER_STATS:
+		{
+			const auto& stats = m_pacer.GetStats();
+			out = {
+				{"speedMul", m_speedMul},
+				{"audioPacing", m_audioPacing},
+				{"frames", stats.frames},
+				{"lateFrames", stats.lateFrames},
+				{"resyncs", stats.resyncs},
+				{"jitterAvgUs", stats.jitterAvgUs},
+				{"jitterMaxUs", stats.jitterMaxUs},
+				{"driftUs", stats.driftUs},
+				{"sleepOvershootUs", stats.sleepOvershootUs},
+				};
 			break;
 		}
 
@@ -430,9 +518,9 @@ void dev::Hardware::ReqHandling(const bool _waitReq)
 				{"displayMode", m_io.GetDisplayMode()},
 				{"scrollVert", m_display.GetScrollVert()},
 				{"rusLat", (m_io.GetRusLatHistory() & 0b1000) != 0},
-				{"inte", m_cpu.GetState().ints.inte},
-				{"iff", m_cpu.GetState().ints.iff},
-				{"hlta", m_cpu.GetState().ints.hlta},
+				{"inte", m_cpu.GetINTE()},
+				{"iff", m_cpu.GetIFF()},
+				{"hlta", m_cpu.GetHLTA()},
 				};
 				for (int i=0; i < IO::PALETTE_LEN; i++ ){
 					out["palette"+std::to_string(i)] = Display::VectorColorToArgb(paletteP->bytes[i]);
@@ -473,12 +561,19 @@ void dev::Hardware::ReqHandling(const bool _waitReq)
 
 		case Req::DEBUG_ATTACH:
 			m_debugAttached = dataJ["data"];
+			m_cpu.SetMemoryDebug(m_debugAttached);
 			break;
 
 		default:
+			m_cpu.PackState();
 			out = DebugReqHandling(req, dataJ, m_cpu.GetStateP(), m_memory.GetStateP(), m_io.GetStateP(), m_display.GetStateP());
+			// the recorder can restore the cpu state and the memory mapping
+			m_cpu.UnpackState();
+			m_memory.UpdatePages();
 		}
 
+		m_display.RasterizeDeferred();
+
 		m_reqRes.emplace(std::move(out));
 	}
 }
@@ -501,6 +596,8 @@ void dev::Hardware::Stop()
 {
 	m_status = Status::STOP;
 	m_audio.Pause(true);
+	m_display.SetGpuDecode(false);
+	SetFastForward(false);
 }
 
 // to continue execution
@@ -508,12 +605,31 @@ void dev::Hardware::Run()
 {
 	m_status = Status::RUN;
 	m_audio.Pause(false);
+	m_display.SetGpuDecode(m_gpuDecode);
+	SetFastForward(m_speedMul <= 0.0);
+}
+
+// _speedMul multiplies the frame rate. <= 0 - the max speed
+void dev::Hardware::SetSpeed(const double _speedMul)
+{
+	m_speedMul = _speedMul;
+	m_audio.Mute(m_speedMul > 0.0 && m_speedMul < SPEED_MUL_MUTE);
+	m_audio.SetAudioPacing(m_audioPacing && m_speedMul == 1.0);
+	if (m_speedMul > 0.0) m_pacer.SetSpeed(m_speedMul);
+	SetFastForward(m_status == Status::RUN && m_speedMul <= 0.0);
+}
+
+// the max speed skips the pixel rendering and the audio output. the emulated state stays exact
+void dev::Hardware::SetFastForward(const bool _fastForward)
+{
+	m_display.SetFastForward(_fastForward);
+	m_audio.SetFastForward(_fastForward);
 }
 
 auto dev::Hardware::GetRegs() const
 -> nlohmann::json
 {
-	auto& cpuState = m_cpu.GetState();
+	auto cpuState = m_cpu.GetState();
 	nlohmann::json out {
 		{"cc", cpuState.cc },
 		{"pc", cpuState.regs.pc.word },
@@ -637,11 +753,27 @@ auto dev::Hardware::GetRam() const
 	return m_memory.GetRam();
 }
 
+// UI thread. the ui resets the rows it has read
+auto dev::Hardware::GetRamDirtyRows()
+-> Memory::DirtyRows*
+{
+	return m_memory.GetDirtyRows();
+}
+
 // UI thread. Non-blocking reading.
-auto dev::Hardware::GetFrame(const bool _vsync)
+auto dev::Hardware::GetFrame(const bool _vsync, uint64_t* const _frameNumP,
+	uint64_t* const _contentIdP)
 ->const Display::FrameBuffer*
 {
-	return m_display.GetFrame(_vsync);
+	return m_display.GetFrame(_vsync, _frameNumP, _contentIdP);
+}
+
+// UI thread. Non-blocking reading.
+auto dev::Hardware::GetVectorFrame(const bool _vsync, uint64_t* const _frameNumP,
+	uint64_t* const _contentIdP, const Display::VramFrame** _vramFramePP)
+->const Display::VectorFrameBuffer*
+{
+	return m_display.GetVectorFrame(_vsync, _frameNumP, _contentIdP, _vramFramePP);
 }
 
 void dev::Hardware::ExecuteFrameNoBreaks()
@@ -652,6 +784,40 @@ void dev::Hardware::ExecuteFrameNoBreaks()
 	} while (m_display.GetFrameNum() == frameNum);
 }
 
+// executes the frames as fast as possible. it stops when the frame counter is reached,
+// the PC hits the stop addr (-1 disables the check), or the execution breaks
+auto dev::Hardware::ExecuteFrames(const nlohmann::json _dataJ)
+-> nlohmann::json
+{
+	uint64_t frames = _dataJ["frames"];
+	int stopAddr = _dataJ.value("stopAddr", -1);
+
+	auto startCC = m_cpu.GetCC();
+	auto startFrame = m_display.GetFrameNum();
+	bool stopAddrReached = false;
+	bool break_ = false;
+
+	while (m_display.GetFrameNum() - startFrame < frames)
+	{
+		if (ExecuteInstruction()) {
+			break_ = true;
+			break;
+		}
+		if (m_cpu.GetPC() == stopAddr) {
+			stopAddrReached = true;
+			break;
+		}
+	}
+
+	nlohmann::json out = {
+		{"cc", m_cpu.GetCC() - startCC},
+		{"frames", m_display.GetFrameNum() - startFrame},
+		{"stopAddrReached", stopAddrReached},
+		{"break", break_},
+	};
+	return out;
+}
+
 auto dev::Hardware::GetStepOverAddr()
 -> const Addr
 {
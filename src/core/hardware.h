@@ -9,6 +9,7 @@
 
 #include "utils/types.h"
 #include "core/cpu_i8080.h"
+#include "core/hardware_bus.h"
 #include "core/memory.h"
 #include "core/keyboard.h"
 #include "core/io.h"
@@ -17,16 +18,18 @@
 #include "core/sound_ay8910.h"
 #include "core/audio.h"
 #include "core/fdc_wd1793.h"
+#include "core/scheduler.h"
 #include "utils/utils.h"
 #include "utils/result.h"
 #include "utils/tqueue.h"
 #include "utils/json_utils.h"
+#include "utils/frame_pacer.h"
 
 namespace dev 
 {
 	class Hardware
 	{
-		CpuI8080 m_cpu;
+		CpuI8080Bound<HardwareBus> m_cpu;
 		Memory m_memory;
 		Keyboard m_keyboard;
 		IO m_io;
@@ -36,6 +39,7 @@ namespace dev
 		AYWrapper m_aywrapper;
 		Audio m_audio;
 		Fdc1793 m_fdc;
+		Scheduler m_scheduler;
 
 		enum class Status : int {
 			RUN,
@@ -63,9 +67,14 @@ namespace dev
 			const bool _ramDiskClearAfterRestart);
 		~Hardware();
 		auto Request(const Req _req, const nlohmann::json& _dataJ = {}) -> Result <nlohmann::json>;
-		auto GetFrame(const bool _vsync) -> const Display::FrameBuffer*;
+		auto GetFrame(const bool _vsync, uint64_t* const _frameNumP = nullptr,
+			uint64_t* const _contentIdP = nullptr) -> const Display::FrameBuffer*;
+		auto GetVectorFrame(const bool _vsync, uint64_t* const _frameNumP = nullptr,
+			uint64_t* const _contentIdP = nullptr, const Display::VramFrame** _vramFramePP = nullptr)
+			-> const Display::VectorFrameBuffer*;
 		auto GetRam() const -> const Memory::Ram*;
-		auto GetCpuState() -> const CpuI8080::State& { return m_cpu.GetState(); }
+		auto GetRamDirtyRows() -> Memory::DirtyRows*;
+		auto GetCpuState() -> CpuI8080::State { return m_cpu.GetState(); }
 		auto GetMemState() -> const Memory::State& { return m_memory.GetState(); }
 		auto GetIoState() -> const IO::State& { return m_io.GetState(); }
 
@@ -83,18 +92,26 @@ namespace dev
 		TQueue <std::pair<Req, nlohmann::json>> m_reqs; // request
 		TQueue <nlohmann::json> m_reqRes;				// request's result sent back 
 
-		ExecSpeed m_execSpeed = ExecSpeed::NORMAL;
-		std::chrono::microseconds m_execDelays[static_cast<int>(ExecSpeed::LEN)] = { 1996800us, 99840us, 39936us, 19968us, 9984us, 10us };
+		static constexpr double SPEED_MUL_MUTE = 0.5; // the slower speeds are muted
+		double m_execSpeedMuls[static_cast<int>(ExecSpeed::LEN)] = { 0.01, 0.2, 0.5, 1.0, 2.0, 0.0 };
+		double m_speedMul = 1.0; // the frame rate multiplier. <= 0 - the max speed
+		FramePacer m_pacer;
+		bool m_audioPacing = false; // the 1x speed is paced by the audio playback
+		bool m_gpuDecode = false; // the display frames are decoded on the gpu while the emulation runs
 
 		void Init();
 		void Execution();
 		bool ExecuteInstruction();
+		void ScheduleEvents();
 		void ExecuteFrameNoBreaks();
+		auto ExecuteFrames(const nlohmann::json _dataJ) -> nlohmann::json;
 		void ReqHandling(const bool _waitReq = false);
 		void Reset();
 		void Restart();
 		void Stop();
 		void Run();
+		void SetFastForward(const bool _fastForward);
+		void SetSpeed(const double _speedMul);
 		auto GetRegs() const -> nlohmann::json;
 		auto GetByteGlobal(const nlohmann::json _globalAddrJ) -> nlohmann::json;
 		auto GetByte(const nlohmann::json _addrJ, const Memory::AddrSpace _addrSpace) -> nlohmann::json;
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "utils/types.h"
+#include "core/memory.h"
+#include "core/io.h"
+#include "core/display.h"
+#include "core/audio.h"
+
+namespace dev
+{
+	// The Vector06c bus the cpu is bound to at compile time
+	class HardwareBus
+	{
+	public:
+		HardwareBus(Memory& _memory, IO& _io, Display& _display, Audio& _audio)
+			:
+			m_memory(_memory), m_io(_io), m_display(_display), m_audio(_audio)
+		{}
+
+		template <bool DEBUG>
+		inline auto CpuReadInstr(const Addr _addr, const Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
+			-> uint8_t { return m_memory.CpuReadInstr<DEBUG>(_addr, _addrSpace, _byteNum); }
+		template <bool DEBUG>
+		inline auto CpuRead(const Addr _addr, const Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
+			-> uint8_t { return m_memory.CpuRead<DEBUG>(_addr, _addrSpace, _byteNum); }
+		template <bool DEBUG>
+		inline void CpuWrite(const Addr _addr, uint8_t _value, const Memory::AddrSpace _addrSpace, const uint8_t _byteNum)
+		{
+			m_display.VramWrite(m_memory.GetGlobalAddr(_addr, _addrSpace));
+			m_memory.CpuWrite<DEBUG>(_addr, _value, _addrSpace, _byteNum);
+		}
+		inline auto PortIn(const uint8_t _port) -> uint8_t { return m_io.PortIn(_port); }
+		inline void PortOut(const uint8_t _port, const uint8_t _value) { m_io.PortOut(_port, _value); }
+
+		// rasterizes up to the start of the cpu machine cycle, outputs the irq line
+		inline bool BeginMachineCycle()
+		{
+			m_display.Rasterize();
+			return m_display.IsIRQ();
+		}
+
+		inline void EndMachineCycle() { m_audio.Clock(2, m_io.GetBeeper()); }
+
+		// the machine cycles with no device events, see Scheduler. the cpu only
+		// idles through them, so the display and the audio are advanced in one go
+		inline void IdleMachineCycles(const int _machineCycles)
+		{
+			m_display.RasterizeIdle(_machineCycles);
+			m_audio.Clock(2 * _machineCycles, m_io.GetBeeper());
+		}
+
+		inline auto GetMemory() -> Memory& { return m_memory; }
+
+	private:
+		Memory& m_memory;
+		IO& m_io;
+		Display& m_display;
+		Audio& m_audio;
+	};
+}
@@ -10,6 +10,7 @@ enum class Req: int {
 	EXECUTE_INSTR,
 	EXECUTE_FRAME,
 	EXECUTE_FRAME_NO_BREAKS,
+	EXECUTE_FRAMES,			// runs frames without pacing until the frame counter or the stop addr is reached
 	GET_CC,
 	GET_REGS,
 	GET_REG_PC,
@@ -40,9 +41,13 @@ enum class Req: int {
 	SET_DISPLAY_BORDER_LEFT,
 	GET_DISPLAY_IRQ_COMMIT_PXL,
 	SET_DISPLAY_IRQ_COMMIT_PXL,
+	SET_DISPLAY_GPU_DECODE,
 	SET_MEM,
 	SET_BYTE_GLOBAL,
 	SET_CPU_SPEED,
+	GET_PACER_STATS,
+	SET_AUDIO_PACING,
+	SET_AUDIO_OUTPUT_RATE,
 	GET_HW_MAIN_STATS,
 	IS_MEMROM_ENABLED,
 	KEY_HANDLING,
@@ -34,7 +34,7 @@
 #define PALLETE_HI		m_state.palette.hi
 
 dev::IO::IO(Keyboard& _keyboard, Memory& _memory, TimerI8253& _timer,
-	SoundAY8910& _ay, Fdc1793& _fdc)
+	AYWrapper& _ay, Fdc1793& _fdc)
 	:
 	m_keyboard(_keyboard), m_memory(_memory), m_timer(_timer),
 	m_ay(_ay), m_fdc(_fdc)
@@ -53,6 +53,7 @@ void dev::IO::Init()
 
 	OUT_COMMIT_TIMER = PALLETE_COMMIT_TIMER = DISPLAY_MODE_COMMIT_TIMER = 0;
 	m_state.ruslatHistory = 0;
+	m_displayUpdates++;
 }
 
 // I8080 IN NN
@@ -187,11 +188,13 @@ void dev::IO::PortOutHandling(uint8_t _port, uint8_t _value)
 		break;
 	case 0x02:
 		PORT_B = _value;
+		m_displayUpdates += BRD_COLOR_IDX != (PORT_B & 0x0f);
 		BRD_COLOR_IDX = PORT_B & 0x0f;
 		REQ_DISPLAY_MODE = (PORT_B & 0x10) != 0;
 		break;
 		// Vertical Scrolling
 	case 0x03:
+		m_displayUpdates += PORT_A != _value;
 		PORT_A = _value;
 		break;
 		// Parallel Port
@@ -346,6 +349,7 @@ void dev::IO::TryToCommit(const uint8_t _colorIdx)
 	if (DISPLAY_MODE_COMMIT_TIMER > 0) {
 		if (--DISPLAY_MODE_COMMIT_TIMER == 0)
 		{
+			m_displayUpdates += DISPLAY_MODE != (REQ_DISPLAY_MODE != 0);
 			DISPLAY_MODE = REQ_DISPLAY_MODE;
 		}
 	}
@@ -121,25 +121,29 @@ namespace dev
 		Keyboard& m_keyboard;
 		Memory& m_memory;
 		TimerI8253& m_timer;
-		SoundAY8910& m_ay;
+		AYWrapper& m_ay;
 		Fdc1793& m_fdc;
 
 		int m_outCommitTime = OUT_COMMIT_TIME;
 		int m_paletteCommitTime = PALETTE_COMMIT_TIME;
 		int m_displayModeTime = DISPLAY_MODE_COMMIT_TIME;
+		uint64_t m_displayUpdates = 0; // counts the changes of the palette, the border color, the display mode, and the scroll
 
 		void PortOutHandling(uint8_t _port, uint8_t _value);
 		auto PortInHandling(uint8_t _port) -> uint8_t;
 
 	public:
-		IO(Keyboard& _keyboard, Memory& _memory, TimerI8253& _timer, SoundAY8910& _ay, Fdc1793& _fdc);
+		IO(Keyboard& _keyboard, Memory& _memory, TimerI8253& _timer, AYWrapper& _ay, Fdc1793& _fdc);
 		void Init();
 		auto PortIn(uint8_t _port) -> uint8_t;
 		void PortOut(uint8_t _port, uint8_t _value);
 		void PortOutCommit();
 		inline auto GetKeyboard() -> Keyboard& { return m_keyboard; };
 		inline auto GetColor(const uint8_t _colorIdx) const -> uint8_t { return m_state.palette.bytes[_colorIdx]; };
-		inline void SetColor(const uint8_t _idx) { m_state.palette.bytes[_idx] = m_state.hwColor; };
+		inline void SetColor(const uint8_t _idx) {
+			m_displayUpdates += m_state.palette.bytes[_idx] != m_state.hwColor;
+			m_state.palette.bytes[_idx] = m_state.hwColor;
+		};
 		inline auto GetBorderColor() const -> uint8_t { return m_state.palette.bytes[m_state.brdColorIdx]; };
 		inline auto GetBorderColorIdx() const -> uint8_t { return m_state.brdColorIdx; };
 		inline auto GetScroll() const -> uint8_t { return m_state.ports.portA; };
@@ -148,7 +152,15 @@ namespace dev
 		inline auto GetDisplayMode() const -> bool { return m_state.displayMode; };
 		inline auto GetOutCommitTimer() const -> int { return m_state.outCommitTimer; };
 		inline auto GetPaletteCommitTimer() const -> int { return m_state.paletteCommitTimer; };
+		// true if the OUT command, the palette, or the display mode waits to be commited
+		inline bool IsCommitPending() const { return m_state.outCommitTimer > 0 || m_state.paletteCommitTimer > 0 || m_state.displayModeTimer > 0; };
+		// true if the palette, the display mode, or the ports of the border color and the scroll wait to be commited
+		inline bool IsDisplayCommitPending() const {
+			bool displayPort = m_state.outport == 0x00 || m_state.outport == PORT_OUT_DISPLAY_MODE || m_state.outport == 0x03;
+			return m_state.paletteCommitTimer > 0 || m_state.displayModeTimer > 0 || (m_state.outCommitTimer > 0 && displayPort);
+		};
 		inline auto GetPaletteCommitTime() const -> int { return m_paletteCommitTime; };
+		inline auto GetDisplayUpdates() const -> uint64_t { return m_displayUpdates; };
 		inline void SetPaletteCommitTime(const int _paletteCommitTime) { m_paletteCommitTime = _paletteCommitTime; };
 
 		auto GetState() const -> const State& { return m_state; };
@@ -1,6 +1,21 @@
 #include "core/memory.h"
 #include "utils/utils.h"
 
+// moves the bits of a screen byte into the bit 0 of the nibbles,
+// the bit 7 goes to the nibble 0
+static constexpr auto bitsToNibbles = []()
+{
+	std::array<uint32_t, 256> table{};
+	for (int val = 0; val < 256; val++)
+	{
+		for (int bit = 0; bit < 8; bit++)
+		{
+			table[val] |= (uint32_t)((val >> (7 - bit)) & 1) << (bit * 4);
+		}
+	}
+	return table;
+}();
+
 dev::Memory::Memory(const std::string& _pathBootData, const std::string& _pathRamDiskData, 
 	const bool _ramDiskClearAfterRestart)
 	: 
@@ -39,99 +54,155 @@ void dev::Memory::Init()
 	m_state.update.mapping.data = m_state.update.ramdiskIdx = m_mappingsEnabled = 0;
 	m_state.update.memType = MemType::ROM;
 	m_state.ramP = &m_ram;
+
+	UpdatePages();
+	UpdateScreenColumns();
+	SetDirtyRows();
 }
 
-void dev::Memory::Restart() { m_state.update.memType = MemType::RAM; }
+void dev::Memory::Restart()
+{
+	m_state.update.memType = MemType::RAM;
+	UpdatePages();
+}
 
 
 void dev::Memory::SetMemType(const MemType _memType)
 {
 	m_state.update.memType = _memType;
+	UpdatePages();
 }
 void dev::Memory::SetRam(const Addr _addr, const std::vector<uint8_t>& _data )
 {
 	std::copy(_data.begin(), _data.end(), m_ram.data() + _addr);
+
+	for (GlobalAddr globalAddr = _addr; globalAddr < _addr + _data.size(); globalAddr++) {
+		UpdateScreenColumn(globalAddr);
+		m_dirtyRows[globalAddr >> RAM_ROW_SHIFT].store(1, std::memory_order_relaxed);
+	}
+	InvalidateCode();
 }
 
 void dev::Memory::SetByteGlobal(const GlobalAddr _addr, const uint8_t _data)
 {
 	m_ram[_addr] = _data;
+	UpdateScreenColumn(_addr);
+	m_dirtyRows[_addr >> RAM_ROW_SHIFT].store(1, std::memory_order_relaxed);
+	WriteCodeLine(_addr);
 }
 
 auto dev::Memory::GetByte(const Addr _addr, const AddrSpace _addrSpace) const
 -> uint8_t
 {
-	auto globalAddr = GetGlobalAddr(_addr, _addrSpace);
+	auto& page = m_pages[static_cast<int>(_addrSpace)][_addr >> PAGE_SHIFT];
+	GlobalAddr globalAddr = _addr + page.offset;
 
-	return m_state.update.memType == MemType::ROM && globalAddr < m_rom.size() ?
-		m_rom[globalAddr] : m_ram[globalAddr];
+	return globalAddr < page.romEnd ? m_rom[globalAddr] : m_ram[globalAddr];
 }
 
-auto dev::Memory::CpuReadInstr(const Addr _addr, const AddrSpace _addrSpace,
-	const uint8_t _byteNum)
-	-> uint8_t
+// updates the screen column stored at the global addr. the other addrs are ignored
+void dev::Memory::UpdateScreenColumn(const GlobalAddr _globalAddr)
 {
-	auto globalAddr = GetGlobalAddr(_addr, _addrSpace);
-	uint8_t val = m_state.update.memType == MemType::ROM && globalAddr < m_rom.size() ?
-		m_rom[globalAddr] : m_ram[globalAddr];
+	if (_globalAddr < SCREEN_ADDR || _globalAddr >= MEMORY_MAIN_LEN) return;
 
-	m_state.debug.instrGlobalAddr = _byteNum == 0 ? globalAddr : m_state.debug.instrGlobalAddr;
-	m_state.debug.instr[_byteNum] = val;
+	// the buffer 0x8000 holds the bit 3 of the color idxs, the buffer 0xE000 - the bit 0
+	int colorBit = 3 - (int)((_globalAddr - SCREEN_ADDR) / SCREEN_BUFFER_LEN);
+	auto& column = m_screen[_globalAddr % SCREEN_BUFFER_LEN];
 
-	return val;
+	auto columnNew = (column & ~(0x11111111u << colorBit)) | bitsToNibbles[m_ram[_globalAddr]] << colorBit;
+	m_screenUpdates += column != columnNew;
+	column = columnNew;
 }
 
-auto dev::Memory::CpuRead(const Addr _addr, const AddrSpace _addrSpace,
-	const uint8_t _byteNum)
--> uint8_t
+// rebuilds the screen columns from the ram
+void dev::Memory::UpdateScreenColumns()
 {
-	auto globalAddr = GetGlobalAddr(_addr, _addrSpace);
+	m_screenUpdates++;
+	for (int offset = 0; offset < SCREEN_BUFFER_LEN; offset++)
+	{
+		m_screen[offset] =
+			bitsToNibbles[m_ram[SCREEN_ADDR + offset]] << 3 |
+			bitsToNibbles[m_ram[SCREEN_ADDR + SCREEN_BUFFER_LEN + offset]] << 2 |
+			bitsToNibbles[m_ram[SCREEN_ADDR + SCREEN_BUFFER_LEN * 2 + offset]] << 1 |
+			bitsToNibbles[m_ram[SCREEN_ADDR + SCREEN_BUFFER_LEN * 3 + offset]];
+	}
+}
 
-	// debug
-	m_state.debug.readGlobalAddr[_byteNum] = globalAddr;
-	m_state.debug.readLen = _byteNum + 1;
+auto dev::Memory::GetRam() const -> const Ram* { return &m_ram; }
 
-	// return byte
-	return m_state.update.memType == MemType::ROM && globalAddr < m_rom.size() ?
-		m_rom[globalAddr] : m_ram[globalAddr];
+// marks the whole ram changed. it's used when the ram is updated bypassing the memory writes
+void dev::Memory::SetDirtyRows()
+{
+	for (auto& dirtyRow : m_dirtyRows) {
+		dirtyRow.store(1, std::memory_order_relaxed);
+	}
+	InvalidateCode();
 }
 
-// accessed by the CPU
-// byteNum = 0 for the first byte stored by instr, 1 for the second
-// _byteNum is 0 or 1
-void dev::Memory::CpuWrite(const Addr _addr, uint8_t _value,
-	const AddrSpace _addrSpace, const uint8_t _byteNum)
+// the lines the cpu cached the instructions from. the writes into them are tracked
+void dev::Memory::CacheCodeLines(const GlobalAddr _globalAddr, const GlobalAddr _lastGlobalAddr)
 {
-	auto globalAddr = GetGlobalAddr(_addr, _addrSpace);
+	for (auto lineIdx = _globalAddr >> CODE_LINE_SHIFT; lineIdx <= _lastGlobalAddr >> CODE_LINE_SHIFT; lineIdx++) {
+		m_codeLines[lineIdx].cached = true;
+	}
+}
 
-	// debug
-	m_state.debug.beforeWrite[_byteNum] = m_ram[globalAddr];
-	m_state.debug.writeGlobalAddr[_byteNum] = globalAddr;
-	m_state.debug.writeLen = _byteNum + 1;
+// the cached instructions are decoded again
+void dev::Memory::InvalidateCode()
+{
+	m_codeGen++;
+	m_codeUpdates++;
+}
+
+// it raises an exception if the mapping is enabled for more than one Ram-disk.
+// it used the first enabled Ram-disk during an exception
+void dev::Memory::SetRamDiskMode(uint8_t _diskIdx, uint8_t _data) 
+{	
+	m_mappings[_diskIdx].data = _data;
 
-	m_state.debug.write[_byteNum] = _value;
+	m_state.update.mapping.data = 0;
+	m_mappingsEnabled = 0;
 
-	// store byte
-	m_ram[globalAddr] = _value;
+	for (int ramdiskIdx = 0; ramdiskIdx < RAM_DISK_MAX; ramdiskIdx++)
+	{
+		if (m_mappings[ramdiskIdx].data & MAPPING_MODE_MASK)
+		{
+			if (++m_mappingsEnabled > 1) {
+				break;
+			}
+
+			m_state.update.mapping.data = m_mappings[ramdiskIdx].data;
+			m_state.update.ramdiskIdx = ramdiskIdx;
+		}
+	}
+
+	UpdatePages();
 }
 
-// reads 4 bytes from every screen buffer.
-// all of these bytes are visually at the same position on the screen
-auto dev::Memory::GetScreenBytes(Addr _screenAddrOffset) const
--> uint32_t
+// rebuilds the page translation from the mapping and the memory type.
+// it has to be called every time the m_state.update is changed
+void dev::Memory::UpdatePages()
 {
-	auto byte8 = m_ram[_screenAddrOffset + 0x8000];
-	auto byteA = m_ram[_screenAddrOffset + 0xA000];
-	auto byteC = m_ram[_screenAddrOffset + 0xC000];
-	auto byteE = m_ram[_screenAddrOffset + 0xE000];
+	GlobalAddr romEnd = m_state.update.memType == MemType::ROM ? (GlobalAddr)m_rom.size() : 0;
+	// the rom switch and the ram-disk remapping invalidate the cached instructions
+	InvalidateCode();
 
-	return byte8 << 24 | byteA << 16 | byteC << 8 | byteE;
-}
+	for (int pageIdx = 0; pageIdx < PAGES; pageIdx++)
+	{
+		Addr addr = pageIdx << PAGE_SHIFT;
 
-auto dev::Memory::GetRam() const -> const Ram* { return &m_ram; }
+		for (auto addrSpace : { AddrSpace::RAM, AddrSpace::STACK })
+		{
+			auto& page = m_pages[static_cast<int>(addrSpace)][pageIdx];
+			page.offset = TranslateAddr(addr, addrSpace) - addr;
+			page.romEnd = romEnd;
+		}
+	}
+}
 
-// converts the addr to a global addr depending on the ram/stack mapping modes
-auto dev::Memory::GetGlobalAddr(const Addr _addr, const AddrSpace _addrSpace) const
+// converts the addr to a global addr depending on the ram/stack mapping modes.
+// the mapping ranges are aligned to the page size
+auto dev::Memory::TranslateAddr(const Addr _addr, const AddrSpace _addrSpace) const
 -> GlobalAddr
 {
 	// if no mapping enabled, return _addr
@@ -153,29 +224,6 @@ auto dev::Memory::GetGlobalAddr(const Addr _addr, const AddrSpace _addrSpace) co
 	return _addr;
 }
 
-// it raises an exception if the mapping is enabled for more than one Ram-disk.
-// it used the first enabled Ram-disk during an exception
-void dev::Memory::SetRamDiskMode(uint8_t _diskIdx, uint8_t _data) 
-{	
-	m_mappings[_diskIdx].data = _data;
-
-	m_state.update.mapping.data = 0;
-	m_mappingsEnabled = 0;
-
-	for (int ramdiskIdx = 0; ramdiskIdx < RAM_DISK_MAX; ramdiskIdx++)
-	{
-		if (m_mappings[ramdiskIdx].data & MAPPING_MODE_MASK)
-		{
-			if (++m_mappingsEnabled > 1) {
-				break;
-			}
-
-			m_state.update.mapping.data = m_mappings[ramdiskIdx].data;
-			m_state.update.ramdiskIdx = ramdiskIdx;
-		}
-	}
-}
-
 bool dev::Memory::IsException()
 {
 	auto out = m_mappingsEnabled > 1;
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <string>
@@ -21,6 +22,25 @@ namespace dev
 		using Ram = std::array<uint8_t, MEMORY_GLOBAL_LEN>;
 		using RamDiskData = std::vector<uint8_t>;
 
+		// the ram is tracked for changes by rows for the ui. a row is marked by the hardware thread
+		// and reset by the ui thread after it got the row data
+		static constexpr int RAM_ROW_SHIFT = 8;
+		static constexpr int RAM_ROW_LEN = 1 << RAM_ROW_SHIFT;
+		static constexpr int RAM_ROWS = MEMORY_GLOBAL_LEN / RAM_ROW_LEN;
+		using DirtyRows = std::array<std::atomic_uint8_t, RAM_ROWS>;
+
+		// the instruction blocks cached by the cpu are checked against the generations
+		// of the code lines they were decoded from. a write into a cached line bumps
+		// its generation. the mapping change or the ram update bypassing the cpu
+		// writes bumps the code generation, see CpuI8080Bound::FetchCachedInstr
+		static constexpr int CODE_LINE_SHIFT = 6;
+		static constexpr int CODE_LINE_LEN = 1 << CODE_LINE_SHIFT;
+		static constexpr int CODE_LINES = MEMORY_GLOBAL_LEN / CODE_LINE_LEN;
+
+		// the address translation is precomputed for every 8KB page of the cpu address space
+		static constexpr int PAGE_SHIFT = 13;
+		static constexpr int PAGES = MEM_64K >> PAGE_SHIFT;
+
 #pragma pack(push, 1)
 		// The ram-disk mapping into the RAM memory space
 		// RAM mapping is applied if:
@@ -123,16 +143,27 @@ namespace dev
 		void Restart();
 		auto GetByte(const Addr _addr,
 			const Memory::AddrSpace _addrSpace = Memory::AddrSpace::RAM) const -> uint8_t;
+		// DEBUG = false skips the debugger bookkeeping in m_state.debug
+		template <bool DEBUG = true>
 		auto CpuReadInstr(const Addr _addr,
 			const Memory::AddrSpace _addrSpace = Memory::AddrSpace::RAM,
 			const uint8_t _byteNum = 0) -> uint8_t;
+		template <bool DEBUG = true>
 		auto CpuRead(const Addr _addr,
 			const Memory::AddrSpace _addrSpace = Memory::AddrSpace::RAM,
 			const uint8_t _byteNum = 0) -> uint8_t;
+		template <bool DEBUG = true>
 		void CpuWrite(const Addr _addr, uint8_t _value,
 			const Memory::AddrSpace _addrSpace, const uint8_t _byteNum);
-		auto GetScreenBytes(Addr _screenAddrOffset) const -> uint32_t;
+		inline auto GetScreenColorIdxs(const Addr _screenAddrOffset) const -> uint32_t { return m_screen[_screenAddrOffset]; };
+		inline auto GetScreenUpdates() const -> uint64_t { return m_screenUpdates; };
+		inline auto GetCodeGen() const -> uint64_t { return m_codeGen; };
+		inline auto GetCodeLineGen(const GlobalAddr _globalAddr) const -> uint32_t { return m_codeLines[_globalAddr >> CODE_LINE_SHIFT].gen; };
+		// counts the code generation changes and the writes into the cached lines
+		inline auto GetCodeUpdates() const -> uint64_t { return m_codeUpdates; };
+		void CacheCodeLines(const GlobalAddr _globalAddr, const GlobalAddr _lastGlobalAddr);
 		auto GetRam() const -> const Ram*;
+		auto GetDirtyRows() -> DirtyRows* { return &m_dirtyRows; };
 		auto GetGlobalAddr(const Addr _addr, const AddrSpace _addrSpace) const -> GlobalAddr;
 		auto GetState() const -> const State& { return m_state; };
 		auto GetStateP() -> State* { return &m_state; };
@@ -144,14 +175,128 @@ namespace dev
 		bool IsException();
 		bool IsRomEnabled() const;
 		inline void DebugInit() { m_state.debug.Init(); };
+		void UpdatePages();
+		void UpdateScreenColumn(const GlobalAddr _globalAddr);
+		void UpdateScreenColumns();
+		void SetDirtyRows();
 
 	private:
+		struct Page
+		{
+			GlobalAddr offset = 0; // added to the addr to get the global addr
+			GlobalAddr romEnd = 0; // the global addrs below are read from the rom
+		};
+		// indexed by AddrSpace
+		Page m_pages[2][PAGES];
+
+		auto TranslateAddr(const Addr _addr, const AddrSpace _addrSpace) const -> GlobalAddr;
+		inline void WriteCodeLine(const GlobalAddr _globalAddr);
+		void InvalidateCode();
+
+		// the screen buffers [0x8000-0xFFFF] in the chunky format. every word holds the 4-bit
+		// color idxs of 8 pxls stored at the same offset of the four buffers, the left pxl
+		// is in the low nibble. it is updated every time the screen buffers are written
+		static constexpr GlobalAddr SCREEN_ADDR = 0x8000;
+		static constexpr int SCREEN_BUFFER_LEN = 0x2000;
+		std::array<uint32_t, SCREEN_BUFFER_LEN> m_screen;
+		uint64_t m_screenUpdates = 0; // counts the changes of m_screen
 
 		Ram m_ram;
+		DirtyRows m_dirtyRows;
+		struct CodeLine
+		{
+			uint32_t gen = 0;
+			bool cached = false;
+		};
+		std::array<CodeLine, CODE_LINES> m_codeLines;
+		uint64_t m_codeGen = 0;
+		uint64_t m_codeUpdates = 0;
 		Rom m_rom;
 		State m_state;
 		int m_mappingsEnabled = 0;
 		std::string m_pathRamDiskData;
 		bool m_ramDiskClearAfterRestart = true;
 	};
-}
\ No newline at end of file
+}
+
+// the cpu memory access is inlined into the cpu instruction handlers
+
+// converts the addr to a global addr depending on the ram/stack mapping modes
+inline auto dev::Memory::GetGlobalAddr(const Addr _addr, const AddrSpace _addrSpace) const
+-> GlobalAddr
+{
+	return _addr + m_pages[static_cast<int>(_addrSpace)][_addr >> PAGE_SHIFT].offset;
+}
+
+template <bool DEBUG>
+inline auto dev::Memory::CpuReadInstr(const Addr _addr, const AddrSpace _addrSpace,
+	const uint8_t _byteNum)
+	-> uint8_t
+{
+	auto& page = m_pages[static_cast<int>(_addrSpace)][_addr >> PAGE_SHIFT];
+	GlobalAddr globalAddr = _addr + page.offset;
+	uint8_t val = globalAddr < page.romEnd ? m_rom[globalAddr] : m_ram[globalAddr];
+
+	if constexpr (DEBUG)
+	{
+		m_state.debug.instrGlobalAddr = _byteNum == 0 ? globalAddr : m_state.debug.instrGlobalAddr;
+		m_state.debug.instr[_byteNum] = val;
+	}
+
+	return val;
+}
+
+template <bool DEBUG>
+inline auto dev::Memory::CpuRead(const Addr _addr, const AddrSpace _addrSpace,
+	const uint8_t _byteNum)
+-> uint8_t
+{
+	auto& page = m_pages[static_cast<int>(_addrSpace)][_addr >> PAGE_SHIFT];
+	GlobalAddr globalAddr = _addr + page.offset;
+
+	// debug
+	if constexpr (DEBUG)
+	{
+		m_state.debug.readGlobalAddr[_byteNum] = globalAddr;
+		m_state.debug.readLen = _byteNum + 1;
+	}
+
+	// return byte
+	return globalAddr < page.romEnd ? m_rom[globalAddr] : m_ram[globalAddr];
+}
+
+// accessed by the CPU
+// byteNum = 0 for the first byte stored by instr, 1 for the second
+// _byteNum is 0 or 1
+template <bool DEBUG>
+inline void dev::Memory::CpuWrite(const Addr _addr, uint8_t _value,
+	const AddrSpace _addrSpace, const uint8_t _byteNum)
+{
+	auto globalAddr = GetGlobalAddr(_addr, _addrSpace);
+
+	// debug
+	if constexpr (DEBUG)
+	{
+		m_state.debug.beforeWrite[_byteNum] = m_ram[globalAddr];
+		m_state.debug.writeGlobalAddr[_byteNum] = globalAddr;
+		m_state.debug.writeLen = _byteNum + 1;
+
+		m_state.debug.write[_byteNum] = _value;
+	}
+
+	// store byte
+	m_ram[globalAddr] = _value;
+	m_dirtyRows[globalAddr >> RAM_ROW_SHIFT].store(1, std::memory_order_relaxed);
+	WriteCodeLine(globalAddr);
+
+	if (globalAddr >= SCREEN_ADDR && globalAddr < MEMORY_MAIN_LEN) UpdateScreenColumn(globalAddr);
+}
+
+inline void dev::Memory::WriteCodeLine(const GlobalAddr _globalAddr)
+{
+	auto& codeLine = m_codeLines[_globalAddr >> CODE_LINE_SHIFT];
+	if (!codeLine.cached) return;
+
+	codeLine.gen++;
+	m_codeUpdates++;
+}
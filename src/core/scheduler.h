@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+namespace dev
+{
+	// The devices register the cpu cycle of their next event. The cpu runs
+	// without polling them straight up to the earliest one
+	class Scheduler
+	{
+	public:
+		enum class Event : int {
+			IRQ = 0,	// the display interrupt request at the irq commit pxl
+			FRAME_END,	// the display buffers swap
+			SCROLL,		// the display scroll latch at the top of the active area
+			IO_COMMIT,	// the pending port, palette, and display mode commits
+			TIMER,		// the timer output edge
+			FDC,		// the floppy controller
+			LEN };
+
+		static constexpr uint64_t NEVER = UINT64_MAX;
+
+		Scheduler() { Reset(); }
+		inline void Set(const Event _event, const uint64_t _cc) { m_events[static_cast<int>(_event)] = _cc; }
+		inline auto Get(const Event _event) const -> uint64_t { return m_events[static_cast<int>(_event)]; }
+		inline void Reset() { m_events.fill(NEVER); }
+
+		// the earliest event cycle
+		inline auto GetNext() const -> uint64_t
+		{
+			uint64_t next = NEVER;
+			for (auto cc : m_events) next = cc < next ? cc : next;
+			return next;
+		}
+
+	private:
+		std::array<uint64_t, static_cast<int>(Event::LEN)> m_events;
+	};
+}
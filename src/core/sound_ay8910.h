@@ -7,6 +7,9 @@
 
 #include <string.h>
 #include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <vector>
 
 class SoundAY8910
 {
@@ -22,7 +25,50 @@ class SoundAY8910
     int noir;
     int ayreg;
 
+    // the steps the counter needs to reach its period
+    static int StepsToWrap(int _counter, int _period)
+    {
+        return _period > _counter ? _period - _counter : 1;
+    }
+
+    // advances the counter by _steps, returns how many times it reached its period
+    static int Wraps(int& _counter, int _period, int _steps)
+    {
+        int first = StepsToWrap(_counter, _period);
+        if (_steps < first) {
+            _counter += _steps;
+            return 0;
+        }
+        int rest = _steps - first;
+        int period = std::max(_period, 1);
+        _counter = rest % period;
+        return 1 + rest / period;
+    }
+
+    // the same as _wraps estep calls
+    void esteps(int _wraps)
+    {
+        for (; _wraps > 0; _wraps--) {
+            if (this->envx >> 4 && this->ay13 & 1) { // ENV.HOLD, the envelope does not change anymore
+                this->envv = this->estep();
+                return;
+            }
+            // the envelope repeats itself every 32 steps once it started
+            if (this->envx > 0 && !(this->ay13 & 1) && _wraps > 32) {
+                _wraps = (_wraps - 1) % 32 + 1;
+            }
+            this->envv = this->estep();
+        }
+    }
+
 public:
+    static constexpr uint8_t REG_MASKS[16] = {
+        0xff, 0x0f, 0xff, 0x0f,
+        0xff, 0x0f, 0x1f, 0xff,
+        0x1f, 0x1f, 0x1f, 0xff,
+        0xff, 0x0f, 0xff, 0xff
+    };
+
     SoundAY8910() { Reset(); }
     void Reset() { Init(); }
     void Init()
@@ -39,7 +85,8 @@ public:
         this->ayreg = 0;
     }
 
-    float cstep(int ch)
+    // the channel output of the current state
+    float cmix(int ch)
     {
         static const float amp[] = {
             0.0f, 0.0137f, 0.0205f, 0.0291f,
@@ -48,11 +95,6 @@ public:
             0.5704f, 0.6873f, 0.8482f, 1.0f
         };
 
-        if (++this->ayr[ch + 16] >= (this->ayr[ch << 1] | this->ayr[1 | (ch << 1)] << 8)) {
-            this->ayr[ch + 16] = 0;
-            this->tons ^= 1 << ch;
-        }
-
         int mode_l = this->ayr[8 + ch] & 0x10;  // channel M bit: 1 = env, 0 = ayr[8+ch] lsb
         int mixer = this->ayr[7];               // ayr[7] mixer control: x x nC nB nA tC tB tA
         int tone_ena_l = mixer >> ch;           // tone enable
@@ -65,6 +107,15 @@ public:
         return result;
     }
 
+    float cstep(int ch)
+    {
+        if (++this->ayr[ch + 16] >= (this->ayr[ch << 1] | this->ayr[1 | (ch << 1)] << 8)) {
+            this->ayr[ch + 16] = 0;
+            this->tons ^= 1 << ch;
+        }
+        return cmix(ch);
+    }
+
     int estep()
     {
         if (this->envx >> 4) {
@@ -92,6 +143,62 @@ public:
             this->cstep(2) ) / 3.0f;
     }
 
+    // the output after the last Clock
+    float Output()
+    {
+        return (this->cmix(0) + this->cmix(1) +
+            this->cmix(2)) / 3.0f;
+    }
+
+    // the steps up to the next counter event that can change the output.
+    // the counters of the disabled and the silent channels are not taken into account
+    int StepsToEvent()
+    {
+        int mixer = this->ayr[7];
+        int steps = INT_MAX;
+        bool envUsed = false;
+        bool noiseUsed = false;
+
+        for (int ch = 0; ch < 3; ch++)
+        {
+            int vol = this->ayr[8 + ch];
+            if (!(vol & 0x1f)) continue;
+
+            envUsed |= (vol & 0x10) != 0;
+            noiseUsed |= !(mixer >> (ch + 3) & 1);
+            if (!(mixer >> ch & 1)) {
+                int period = this->ayr[ch << 1] | this->ayr[1 | (ch << 1)] << 8;
+                steps = std::min(steps, StepsToWrap(this->ayr[ch + 16], period));
+            }
+        }
+        if (envUsed) {
+            steps = std::min(steps, StepsToWrap(this->envc, this->ayr[11] << 1 | this->ayr[12] << 9));
+        }
+        if (noiseUsed) {
+            steps = std::min(steps, StepsToWrap(this->noic, this->ayr[6] << 1));
+        }
+        return steps;
+    }
+
+    // advances the envelope, the noise, and the tone counters by _steps Clock calls
+    // without mixing the output. the tones and the envelope are stepped by their periods
+    void Advance(int _steps)
+    {
+        this->esteps(Wraps(this->envc, this->ayr[11] << 1 | this->ayr[12] << 9, _steps));
+
+        for (int wraps = Wraps(this->noic, this->ayr[6] << 1, _steps); wraps > 0; wraps--) {
+            this->noiv = this->noir & 1;
+            this->noir = (this->noir ^ (this->noiv * 0x24000)) >> 1;
+        }
+
+        for (int ch = 0; ch < 3; ch++) {
+            int period = this->ayr[ch << 1] | this->ayr[1 | (ch << 1)] << 8;
+            if (Wraps(this->ayr[ch + 16], period, _steps) & 1) {
+                this->tons ^= 1 << ch;
+            }
+        }
+    }
+
     void aymute()
     {
         if (++this->envc >= (this->ayr[11] << 1 | this->ayr[12] << 9)) {
@@ -122,18 +229,11 @@ public:
 
     void Write(int addr, int val)
     {
-        static const uint8_t rmask[] = {
-            0xff, 0x0f, 0xff, 0x0f,
-            0xff, 0x0f, 0x1f, 0xff,
-            0x1f, 0x1f, 0x1f, 0xff,
-            0xff, 0x0f, 0xff, 0xff
-        };
-
         if (addr == 1) {
             this->ayreg = val & 0x0f;
         }
         else {
-            this->ayr[this->ayreg] = val & rmask[this->ayreg];
+            this->ayr[this->ayreg] = val & REG_MASKS[this->ayreg];
             if (this->ayreg == 13) {
                 this->envx = 0;
                 this->ay13 = ((val & 0xc) == 0x00) ? 9 : ((val & 0xc) == 4) ? 15 : val;
@@ -152,43 +252,152 @@ public:
 };
 
 
+// renders the AY output in spans. the counters are stepped from one output change
+// to the next. the cpu writes are time-stamped and applied at their time
 class AYWrapper
 {
 private:
+    static constexpr int CYCLES_PER_SAMPLE = 2;
+    static constexpr int AY_ACCU_PER_SAMPLE = 7 * CYCLES_PER_SAMPLE;
+    static constexpr int AY_ACCU_PER_STEP = 96;
+
+    struct RegWrite
+    {
+        int cycles; // since the last render
+        int addr;
+        int val;
+    };
+
     SoundAY8910& ay;
     float last;
     int ayAccu;
     int instr_accu;
 
+    int cycles; // clocked since the last render
+    std::vector<RegWrite> writes; // not rendered yet
+    bool outputChanged; // a write can change the output without a counter event
+    // the registers as the cpu sees them
+    int regs[16];
+    int reg;
+
+    void Fill(float* _samples, int _from, int _to, float _val)
+    {
+        if (!_samples) return;
+        for (int i = _from; i < _to; i++) {
+            _samples[i] += _val;
+        }
+    }
+
+    // renders the samples [_from, _to) with no writes in between
+    void RenderSpan(float* _samples, int _from, int _to)
+    {
+        int pos = _from;
+        while (pos < _to)
+        {
+            int64_t steps = this->outputChanged ? 1 : this->ay.StepsToEvent();
+            // the sample the event step happens at
+            int64_t eventSamples = (AY_ACCU_PER_STEP * steps - this->ayAccu + AY_ACCU_PER_SAMPLE - 1) / AY_ACCU_PER_SAMPLE;
+
+            if (pos + eventSamples > _to)
+            {
+                int accu = this->ayAccu + AY_ACCU_PER_SAMPLE * (_to - pos);
+                this->ay.Advance(accu / AY_ACCU_PER_STEP);
+                this->ayAccu = accu % AY_ACCU_PER_STEP;
+                Fill(_samples, pos, _to, this->last);
+                pos = _to;
+            }
+            else {
+                Fill(_samples, pos, pos + (int)eventSamples - 1, this->last);
+                this->ay.Advance((int)steps);
+                this->last = this->ay.Output();
+                this->outputChanged = false;
+                pos += (int)eventSamples;
+                Fill(_samples, pos - 1, pos, this->last);
+                this->ayAccu += AY_ACCU_PER_SAMPLE * (int)eventSamples - AY_ACCU_PER_STEP * (int)steps;
+            }
+        }
+    }
+
 public:
     AYWrapper(SoundAY8910& _ay) : ay(_ay)
     {
         Init();
+        this->writes.reserve(256);
     }
 
     void Reset()
     {
         ay.Reset();
+        this->cycles = 0;
+        this->writes.clear();
+        this->outputChanged = true;
+        memset(this->regs, 0, sizeof(regs));
+        this->reg = 0;
     }
 
     void Init()
     {
         ayAccu = instr_accu = 0;
         last = 0.0;
+        this->cycles = 0;
+        this->writes.clear();
+        this->outputChanged = true;
+        memset(this->regs, 0, sizeof(regs));
+        this->reg = 0;
     }
 
-    float Clock(int _cycles)
+    // only counts the cycles. the output is rendered by Render
+    void Clock(int _cycles) { this->cycles += _cycles; }
+
+    // the registers are visible to the cpu at once. the synthesis gets the write at its time
+    void Write(int addr, int val)
     {
-        this->ayAccu += 7 * _cycles;
-        float aysamp = 0;
-        int avg = 0;
-        for (; this->ayAccu >= 96; this->ayAccu -= 96) {
-            aysamp += this->ay.Clock();
-            ++avg;
+        if (addr == 1) {
+            this->reg = val & 0x0f;
         }
-        this->last = avg > 0 ? aysamp / avg : this->last;
-        return this->last;
+        else {
+            this->regs[this->reg] = val & SoundAY8910::REG_MASKS[this->reg];
+        }
+        this->writes.push_back({ this->cycles, addr, val });
     }
-};
 
+    int Read(int addr)
+    {
+        if (addr == 1) {
+            return this->reg;
+        }
+        return this->regs[this->reg];
+    }
+
+    // mixes the output of the first _samplesLen clocked samples into _samples.
+    // every sample is CYCLES_PER_SAMPLE cycles. _samples can be nullptr to only advance the state
+    void Render(float* _samples, const int _samplesLen)
+    {
+        int pos = 0;
+        size_t writeIdx = 0;
+        while (pos < _samplesLen)
+        {
+            int spanEnd = _samplesLen;
+            for (; writeIdx < this->writes.size(); writeIdx++)
+            {
+                const auto& write = this->writes[writeIdx];
+                int writePos = write.cycles / CYCLES_PER_SAMPLE;
+                if (writePos > pos) {
+                    spanEnd = std::min(spanEnd, writePos);
+                    break;
+                }
+                this->ay.Write(write.addr, write.val);
+                this->outputChanged = true;
+            }
+            RenderSpan(_samples, pos, spanEnd);
+            pos = spanEnd;
+        }
 
+        int renderedCycles = _samplesLen * CYCLES_PER_SAMPLE;
+        this->writes.erase(this->writes.begin(), this->writes.begin() + writeIdx);
+        for (auto& write : this->writes) {
+            write.cycles -= renderedCycles;
+        }
+        this->cycles -= renderedCycles;
+    }
+};
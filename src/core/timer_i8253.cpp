@@ -273,6 +273,25 @@ int dev::CounterUnit::Read()
     return value;
 }
 
+// the lower bound of the ticks before the out changes. the edge happens
+// on the returned tick counting from one, 0 means the load is pending
+auto dev::CounterUnit::GetTicksToEdge() const
+-> int
+{
+    if (m_flagLoad) return 0;
+    if (!m_flagEnabled) return TimerI8253::NO_EDGE;
+
+    switch (m_modeInt) {
+    case 0: // the out goes high once on the terminal count
+        if (!m_flagArmed) return TimerI8253::NO_EDGE;
+        return m_delay + (m_value > 1 ? m_value : 1);
+    case 3: // every tick counts down by 3 at most
+        return m_delay + (m_value > 3 ? (m_value + 2) / 3 : 1);
+    default: // the out stays the same
+        return TimerI8253::NO_EDGE;
+    }
+}
+
 uint16_t dev::CounterUnit::ToBcd(uint16_t _x) 
 {
     int result = 0;
@@ -357,4 +376,15 @@ auto dev::TimerI8253::Clock(int _cycles)
     auto ch1 = m_counters[1].Clock(_cycles);
     auto ch2 = m_counters[2].Clock(_cycles);
     return (ch0 + ch1 + ch2) / 3.0f;
-}
\ No newline at end of file
+}
+
+auto dev::TimerI8253::GetTicksToEdge() const
+-> int
+{
+    int ticks = NO_EDGE;
+    for (auto& counter : m_counters) {
+        int counterTicks = counter.GetTicksToEdge();
+        ticks = counterTicks < ticks ? counterTicks : ticks;
+    }
+    return ticks;
+}
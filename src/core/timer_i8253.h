@@ -40,6 +40,7 @@ namespace dev
         int Clock(int _cycles);
         void Write(uint8_t _w8);
         int Read();
+        auto GetTicksToEdge() const -> int;
         static uint16_t ToBcd(uint16_t _x);
         static uint16_t FromBcd(uint16_t _x);
     };
@@ -57,5 +58,9 @@ namespace dev
         void Write(int _addr, uint8_t _w8);
         auto Read(int _addr) -> int;
         auto Clock(int _cycles) -> float;
+        // the ticks before the earliest output edge, NO_EDGE if no output changes
+        auto GetTicksToEdge() const -> int;
+
+        static constexpr int NO_EDGE = INT32_MAX;
     };
 }
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include <chrono>
+
+#include "headless_app.h"
+
+#include "utils/utils.h"
+#include "utils/str_utils.h"
+#include "core/fdd_consts.h"
+
+dev::HeadlessApp::HeadlessApp(const std::string& _pathBootData, 
+	const std::string& _pathRamDiskData, const bool _ramDiskClearAfterRestart)
+{
+	m_hardwareP = std::make_unique < dev::Hardware>(_pathBootData, _pathRamDiskData, _ramDiskClearAfterRestart);
+	// the debugger is required to restore recordings. it stays detached during the run
+	m_debuggerP = std::make_unique < dev::Debugger>(*m_hardwareP);
+}
+
+dev::HeadlessApp::~HeadlessApp()
+{
+	m_debuggerP.reset();
+	m_hardwareP.reset();
+}
+
+bool dev::HeadlessApp::Load(const std::string& _path, const int _driveIdx)
+{
+	auto ext = StrToUpper(dev::GetExt(_path));
+
+	if (ext == EXT_ROM) return LoadRom(_path);
+	if (ext == EXT_FDD) return LoadFdd(_path, _driveIdx);
+	if (ext == EXT_REC) return LoadRecording(_path);
+
+	dev::Log("Unsupported file type: {}", _path);
+	return false;
+}
+
+bool dev::HeadlessApp::LoadRom(const std::string& _path)
+{
+	auto result = dev::LoadFile(_path);
+	if (!result || result->empty()) {
+		dev::Log("Error occurred while loading the file. Path: {}", _path);
+		return false;
+	}
+
+	m_hardwareP->Request(Hardware::Req::STOP);
+	m_hardwareP->Request(Hardware::Req::RESET);
+	m_hardwareP->Request(Hardware::Req::RESTART);
+
+	auto reqData = nlohmann::json({ {"data", *result}, {"addr", Memory::ROM_LOAD_ADDR} });
+	m_hardwareP->Request(Hardware::Req::SET_MEM, reqData);
+
+	Log("File loaded: {}", _path);
+	return true;
+}
+
+bool dev::HeadlessApp::LoadFdd(const std::string& _path, const int _driveIdx)
+{
+	auto fddResult = dev::LoadFile(_path);
+	if (!fddResult || fddResult->empty()) {
+		dev::Log("Fdc1793 Error: loading error. Path: {}", _path);
+		return false;
+	}
+
+	auto fddimg = *fddResult;
+	if (fddimg.size() > FDD_SIZE) {
+		dev::Log("Fdc1793 Warning: disk image is too big. "
+			"It size will be concatenated to {}. Original size: {} bytes, path: {}", FDD_SIZE, fddimg.size(), _path);
+		fddimg.resize(FDD_SIZE);
+	}
+
+	m_hardwareP->Request(Hardware::Req::STOP);
+	m_hardwareP->Request(Hardware::Req::LOAD_FDD, {
+		{"data", fddimg },
+		{"driveIdx", _driveIdx},
+		{"path", _path}
+		});
+	m_hardwareP->Request(Hardware::Req::RESET);
+	m_restartOnLoadFdd = true;
+
+	Log("File loaded: {}", _path);
+	return true;
+}
+
+bool dev::HeadlessApp::LoadRecording(const std::string& _path)
+{
+	auto result = dev::LoadFile(_path);
+	if (!result || result->empty()) {
+		dev::Log("Error occurred while loading the file. Path: {}", _path);
+		return false;
+	}
+
+	m_hardwareP->Request(Hardware::Req::STOP);
+	m_hardwareP->Request(Hardware::Req::RESET);
+	m_hardwareP->Request(Hardware::Req::RESTART);
+	m_hardwareP->Request(Hardware::Req::DEBUG_RECORDER_DESERIALIZE, { {"data", nlohmann::json::binary(*result)} });
+
+	Log("File loaded: {}", _path);
+	return true;
+}
+
+// the hardware thread executes the frames back-to-back without the frame pacing
+void dev::HeadlessApp::Run(const uint64_t _frames, const int _stopAddr)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	uint64_t cc = 0;
+	uint64_t frames = 0;
+	bool stopAddrReached = false;
+	bool break_ = false;
+
+	// frame by frame to let the boot loader of the fdd be restarted the same way the UI does
+	while (frames < _frames && !stopAddrReached && !break_)
+	{
+		auto res = *m_hardwareP->Request(Hardware::Req::EXECUTE_FRAMES, {
+			{"frames", m_restartOnLoadFdd ? 1 : _frames - frames},
+			{"stopAddr", _stopAddr}
+			});
+
+		cc += res["cc"].get<uint64_t>();
+		frames += res["frames"].get<uint64_t>();
+		stopAddrReached = res["stopAddrReached"];
+		break_ = res["break"];
+
+		if (m_restartOnLoadFdd) RestartOnLoadFdd();
+	}
+
+	std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+
+	double emulatedSec = double(cc) / CpuI8080::CLOCK;
+	double hostSec = elapsedTime.count();
+
+	m_statsJ = {
+		{"cc", cc},
+		{"frames", frames},
+		{"stopAddrReached", stopAddrReached},
+		{"break", break_},
+	};
+	m_statsJ["hostSec"] = hostSec;
+	m_statsJ["emulatedSec"] = emulatedSec;
+	m_statsJ["speed"] = hostSec > 0.0 ? emulatedSec / hostSec : 0.0;
+
+	dev::Log("Executed frames: {}, cpu cycles: {}, emulated seconds: {}, host seconds: {}",
+		uint64_t(m_statsJ["frames"]), cc, emulatedSec, hostSec);
+}
+
+// the boot loader blinks the ruslat while it waits for a restart after loading the fdd
+void dev::HeadlessApp::RestartOnLoadFdd()
+{
+	auto ruslatHistoryJ = *m_hardwareP->Request(Hardware::Req::GET_RUSLAT_HISTORY);
+	auto ruslatHistory = ruslatHistoryJ["data"].get<uint32_t>();
+	bool newRusLat = (ruslatHistory & 0b1000) != 0;
+
+	if (newRusLat != m_ruslat) {
+		if (m_rustLatSwitched++ > 2)
+		{
+			m_rustLatSwitched = 0;
+			auto romEnabledJ = *m_hardwareP->Request(Hardware::Req::IS_MEMROM_ENABLED);
+			if (romEnabledJ["data"]) {
+				m_hardwareP->Request(Hardware::Req::RESTART);
+			}
+		}
+	}
+	m_ruslat = newRusLat;
+}
+
+// stores the last completed frame, the cpu registers, and the timing stats
+bool dev::HeadlessApp::SaveResults(const std::string& _outDir)
+{
+	auto dir = _outDir.empty() ? std::string("") : _outDir + "/";
+
+	auto regsJ = *m_hardwareP->Request(Hardware::Req::GET_REGS);
+	auto hwStatsJ = *m_hardwareP->Request(Hardware::Req::GET_HW_MAIN_STATS);
+	for (auto& [key, val] : hwStatsJ.items()) {
+		regsJ[key] = val;
+	}
+
+	dev::SaveJson(dir + "regs.json", regsJ);
+	dev::SaveJson(dir + "stats.json", m_statsJ);
+
+	return SaveFrame(dir + "frame.ppm");
+}
+
+// binary PPM. the frame buffer colors are stored as ABGR
+bool dev::HeadlessApp::SaveFrame(const std::string& _path)
+{
+	auto frameP = m_hardwareP->GetFrame(true);
+
+	auto header = std::format("P6\n{} {}\n255\n", Display::FRAME_W, Display::FRAME_H);
+	std::vector<uint8_t> data(header.begin(), header.end());
+	data.reserve(data.size() + Display::FRAME_LEN * 3);
+
+	for (auto color : *frameP)
+	{
+		data.push_back(color & 0xff);
+		data.push_back((color >> 8) & 0xff);
+		data.push_back((color >> 16) & 0xff);
+	}
+
+	return dev::SaveFile(_path, data);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "utils/types.h"
+#include "utils/consts.h"
+#include "utils/json_utils.h"
+
+#include "core/hardware.h"
+#include "core/debugger.h"
+
+namespace dev
+{
+	// runs the emulation without a window, sound, and frame pacing.
+	// it is meant for regression runs on machines with no display or sound card
+	class HeadlessApp
+	{
+		const std::string EXT_ROM = ".ROM";
+		const std::string EXT_FDD = ".FDD";
+		const std::string EXT_REC = ".REC";
+
+		std::unique_ptr <dev::Hardware> m_hardwareP;
+		std::unique_ptr <dev::Debugger> m_debuggerP;
+
+		nlohmann::json m_statsJ;
+
+		bool m_restartOnLoadFdd = false;
+		bool m_ruslat = false;
+		int m_rustLatSwitched = 0;
+
+	public:
+		HeadlessApp(const std::string& _pathBootData, const std::string& _pathRamDiskData,
+			const bool _ramDiskClearAfterRestart);
+		~HeadlessApp();
+
+		bool Load(const std::string& _path, const int _driveIdx);
+		void Run(const uint64_t _frames, const int _stopAddr);
+		bool SaveResults(const std::string& _outDir);
+
+	private:
+		bool LoadRom(const std::string& _path);
+		bool LoadFdd(const std::string& _path, const int _driveIdx);
+		bool LoadRecording(const std::string& _path);
+		bool SaveFrame(const std::string& _path);
+		void RestartOnLoadFdd();
+	};
+}
@@ -0,0 +1,70 @@
+#include <format>
+#include <string>
+#include <charconv>
+
+#include "utils/args_parser.h"
+#include "utils/consts.h"
+#include "utils/utils.h"
+#include "headless_app.h"
+
+int main(int argc, char** argv)
+{
+	dev::ArgsParser argsParser(argc, argv,
+		"This is a headless runner of the Vector06C emulator. "
+		"It executes a rom/fdd/rec file with no frame pacing, then stores the last frame, the registers, and the timing stats.");
+
+	auto path = argsParser.GetString("path",
+		"The path to the rom/fdd/rec file.", true);
+
+	auto frames = argsParser.GetInt("frames",
+		"The amount of frames to execute.", false, 50);
+
+	auto stopAddrS = argsParser.GetString("stopAddr",
+		"Stops the execution when the PC reaches this addr. Hex values start with 0x. -1 disables it.", false, "-1");
+
+	auto driveIdx = argsParser.GetInt("driveIdx",
+		"The fdd drive index to mount the fdd file to.", false, 0);
+
+	auto outDir = argsParser.GetString("outDir",
+		"The directory where frame.ppm, regs.json, and stats.json are stored.", false, ".");
+
+	auto pathBootData = argsParser.GetString("bootPath",
+		"The path to the boot rom relative to the executable.", false, "boot//boot.bin");
+
+	auto pathRamDiskData = argsParser.GetString("ramDiskDataPath",
+		"The path to the ram-disk data relative to the executable.", false, "ramDisks.bin");
+
+	if (!argsParser.IsRequirementSatisfied()) return (int)dev::ErrCode::UNSPECIFIED;
+
+	if (!dev::IsFileExist(path)) {
+		dev::Log("A path is invalid: {}", path);
+		return (int)dev::ErrCode::NO_FILES;
+	}
+
+	if (frames < 0) {
+		dev::Log("The frames can not be negative: {}", frames);
+		return (int)dev::ErrCode::UNSPECIFIED;
+	}
+
+	int stopAddr = -1;
+	if (stopAddrS != "-1")
+	{
+		bool hex = stopAddrS.starts_with("0x") || stopAddrS.starts_with("0X");
+		const char* first = stopAddrS.data() + (hex ? 2 : 0);
+		const char* last = stopAddrS.data() + stopAddrS.size();
+		auto [ptr, ec] = std::from_chars(first, last, stopAddr, hex ? 16 : 10);
+
+		if (ec != std::errc() || ptr != last || stopAddr < 0 || stopAddr > 0xFFFF) {
+			dev::Log("A stopAddr is invalid: {}", stopAddrS);
+			return (int)dev::ErrCode::UNSPECIFIED;
+		}
+	}
+
+	dev::HeadlessApp app(pathBootData, pathRamDiskData, true);
+	if (!app.Load(path, driveIdx)) return (int)dev::ErrCode::NO_FILES;
+
+	app.Run(frames, stopAddr);
+	if (!app.SaveResults(outDir)) return (int)dev::ErrCode::UNSPECIFIED;
+
+	return (int)dev::ErrCode::NO_ERRORS;
+}
@@ -26,13 +26,23 @@ const char* fragShaderS = R"#(
 
 	in vec2 uv0;
 
-	uniform sampler2D texture0;
+	uniform sampler2D texture0; // Vector06c colors
 	uniform vec4 m_activeArea_pxlSize;
 	uniform vec4 m_bordsLRTB;
 	uniform vec4 m_scrollV_crtXY_highlightMul;
 
 	layout (location = 0) out vec4 out0;
 
+	// Vector color format: BBGGGRRR
+	vec3 VectorColorToRgb(float _vColor)
+	{
+		int vColor = int(_vColor * 255.0f + 0.5f);
+		return vec3(
+			float(vColor & 7) * 32.0f,
+			float((vColor >> 3) & 7) * 32.0f,
+			float((vColor >> 6) & 3) * 64.0f) / 255.0f;
+	}
+
 	void main()
 	{
 		vec2 uv = uv0;
@@ -55,7 +65,7 @@ const char* fragShaderS = R"#(
 			uv.y += uv.y < bordT ? m_activeArea_pxlSize.y * pxlSize.y : 0.0f;
 		}
 
-		vec3 color = texture(texture0, uv).rgb;
+		vec3 color = VectorColorToRgb(texture(texture0, uv).r);
 
 		// crt scanline highlight
 		if (highlightMul < 1.0f)
@@ -81,6 +91,62 @@ const char* fragShaderS = R"#(
 	}
 )#";
 
+// decodes the frame from the screen memory the same way the rasterizer does.
+// renders a Vector06c color per a frame pixel
+const char* decodeFragShaderS = R"#(
+	#version 330 core
+	precision highp float;
+	precision highp int;
+
+	uniform sampler2D texture0; // the screen memory 0x8000-0xFFFF. 256 bytes per a row
+	uniform sampler2D texture1; // the palette. Vector06c colors
+	uniform vec4 m_vramParams;
+
+	layout (location = 0) out vec4 out0;
+
+	const int SCAN_ACTIVE_AREA_TOP = 40;
+	const int ACTIVE_AREA_W = 512;
+	const int ACTIVE_AREA_H = 256;
+	const int SCREEN_PLANE_ROWS = 32; // 0x2000 bytes
+
+	int FetchByte(sampler2D _texture, ivec2 _pos)
+	{
+		return int(texelFetch(_texture, _pos, 0).r * 255.0f + 0.5f);
+	}
+
+	void main()
+	{
+		int scrollIdx = int(m_vramParams.x);
+		int colorIdx = int(m_vramParams.y); // border
+		bool mode512 = m_vramParams.z > 0.5f;
+		int borderLeft = int(m_vramParams.w);
+
+		int x = int(gl_FragCoord.x) - borderLeft;
+		int y = int(gl_FragCoord.y) - SCAN_ACTIVE_AREA_TOP;
+
+		if (x >= 0 && x < ACTIVE_AREA_W && y >= 0 && y < ACTIVE_AREA_H)
+		{
+			int lineScrolled = (y + (255 - scrollIdx) + ACTIVE_AREA_H) % ACTIVE_AREA_H;
+			int addrLow = ACTIVE_AREA_H - 1 - lineScrolled;
+			int column = x >> 4;
+			int bitIdx = 7 - ((x & 15) >> 1);
+
+			// the buffer 0x8000 holds the bit 3 of the color idxs, the buffer 0xE000 - the bit 0
+			colorIdx = 0;
+			for (int plane = 0; plane < 4; plane++)
+			{
+				int screenByte = FetchByte(texture0, ivec2(addrLow, plane * SCREEN_PLANE_ROWS + column));
+				colorIdx |= ((screenByte >> bitIdx) & 1) << (3 - plane);
+			}
+
+			// in the 512 mode, the even pxls use the bits 0-1, the odd ones - the bits 2-3
+			if (mode512) colorIdx &= (x & 1) != 0 ? 0xC : 0x3;
+		}
+
+		out0 = vec4(texelFetch(texture1, ivec2(colorIdx, 0), 0).r, 0.0f, 0.0f, 1.0f);
+	}
+)#";
+
 dev::DisplayWindow::DisplayWindow(Hardware& _hardware,
 	const float* const _dpiScaleP, GLUtils& _glUtils, ReqUI& _reqUI)
 	:
@@ -98,7 +164,7 @@ bool dev::DisplayWindow::Init()
 	m_vramShaderId = vramShaderId;
 
 	// init texture
-	auto vramTexId = m_glUtils.InitTexture(Display::FRAME_W, Display::FRAME_H, GLUtils::Texture::Format::RGBA);
+	auto vramTexId = m_glUtils.InitTexture(Display::FRAME_W, Display::FRAME_H, GLUtils::Texture::Format::R8);
 	if (vramTexId == INVALID_ID) return false;
 	m_vramTexId = vramTexId;
 
@@ -123,6 +189,33 @@ bool dev::DisplayWindow::Init()
 	m_matParamId_scrollV_crtXY_highlightMul = m_glUtils.GetMaterialParamId(vramMatId, "m_scrollV_crtXY_highlightMul");
 	m_matParamId_activeArea_pxlSize = m_glUtils.GetMaterialParamId(vramMatId, "m_activeArea_pxlSize");
 	m_matParamId_bordsLRTB = m_glUtils.GetMaterialParamId(vramMatId, "m_bordsLRTB");
+	m_drawnMatId = m_vramMatId;
+
+	// init the gpu decode
+	auto decodeShaderId = m_glUtils.InitShader(vtxShaderS, decodeFragShaderS);
+	if (decodeShaderId == INVALID_ID) return false;
+	m_decodeShaderId = decodeShaderId;
+
+	auto decodeVramTexId = m_glUtils.InitTexture(256, Display::SCREEN_LEN / 256, GLUtils::Texture::Format::R8);
+	if (decodeVramTexId == INVALID_ID) return false;
+	m_decodeVramTexId = decodeVramTexId;
+
+	auto decodePaletteTexId = m_glUtils.InitTexture(IO::PALETTE_LEN, 1, GLUtils::Texture::Format::R8);
+	if (decodePaletteTexId == INVALID_ID) return false;
+	m_decodePaletteTexId = decodePaletteTexId;
+
+	auto decodeMatId = m_glUtils.InitMaterial(m_decodeShaderId,
+		{ m_decodeVramTexId, m_decodePaletteTexId }, { { "m_vramParams", m_vramParams } },
+		Display::FRAME_W, Display::FRAME_H);
+	if (decodeMatId == INVALID_ID) return false;
+	m_decodeMatId = decodeMatId;
+	m_matParamId_vramParams = m_glUtils.GetMaterialParamId(decodeMatId, "m_vramParams");
+
+	auto decodedMatId = m_glUtils.InitMaterial(m_vramShaderId,
+		{ m_glUtils.GetFramebufferTexture(m_decodeMatId) }, shaderParams,
+		Display::FRAME_W, Display::FRAME_H);
+	if (decodedMatId == INVALID_ID) return false;
+	m_decodedMatId = decodedMatId;
 
 
 	return true;
@@ -220,13 +313,45 @@ void dev::DisplayWindow::UpdateData(const bool _isRunning)
 		m_scrollV_crtXY_highlightMul.x = 0;//FRAME_PXL_SIZE_H* scrollVert;
 
 		// update params
-		m_glUtils.UpdateMaterialParam(m_vramMatId, m_matParamId_scrollV_crtXY_highlightMul, m_scrollV_crtXY_highlightMul);
-		m_glUtils.UpdateMaterialParam(m_vramMatId, m_matParamId_bordsLRTB, m_bordsLRTB);
-		m_glUtils.UpdateMaterialParam(m_vramMatId, m_matParamId_activeArea_pxlSize, m_activeArea_pxlSize);
+		for (auto matId : { m_vramMatId, m_decodedMatId })
+		{
+			m_glUtils.UpdateMaterialParam(matId, m_matParamId_scrollV_crtXY_highlightMul, m_scrollV_crtXY_highlightMul);
+			m_glUtils.UpdateMaterialParam(matId, m_matParamId_bordsLRTB, m_bordsLRTB);
+			m_glUtils.UpdateMaterialParam(matId, m_matParamId_activeArea_pxlSize, m_activeArea_pxlSize);
+		}
+
+		uint64_t frameContentId;
+		const Display::VramFrame* vramFrameP = nullptr;
+		auto frameP = m_hardware.GetVectorFrame(_isRunning, nullptr, &frameContentId, &vramFrameP);
+
+		bool paramsChanged = m_scrollV_crtXY_highlightMul != m_scrollV_crtXY_highlightMulDrawn ||
+			m_bordsLRTB != m_bordsLRTBDrawn;
+		if (frameContentId == m_frameContentId && !paramsChanged) return;
 
-		auto frameP = m_hardware.GetFrame(_isRunning);
-		m_glUtils.UpdateTexture(m_vramTexId, (uint8_t*)frameP->data());
-		m_glUtils.Draw(m_vramMatId);
+		if (frameContentId != m_frameContentId && vramFrameP)
+		{
+			// the frame was not rasterized. it is decoded from the screen memory
+			m_glUtils.UpdateTexture(m_decodeVramTexId, vramFrameP->vram.data());
+			m_glUtils.UpdateTexture(m_decodePaletteTexId, vramFrameP->palette);
+			m_vramParams = {
+				static_cast<float>(vramFrameP->scrollIdx),
+				static_cast<float>(vramFrameP->borderColorIdx),
+				vramFrameP->mode512 ? 1.0f : 0.0f,
+				static_cast<float>(vramFrameP->borderLeft) };
+			m_glUtils.UpdateMaterialParam(m_decodeMatId, m_matParamId_vramParams, m_vramParams);
+			m_glUtils.Draw(m_decodeMatId);
+			m_drawnMatId = m_decodedMatId;
+		}
+		else if (frameContentId != m_frameContentId)
+		{
+			m_glUtils.UpdateTexture(m_vramTexId, (uint8_t*)frameP->data());
+			m_drawnMatId = m_vramMatId;
+		}
+		m_glUtils.Draw(m_drawnMatId);
+
+		m_frameContentId = frameContentId;
+		m_scrollV_crtXY_highlightMulDrawn = m_scrollV_crtXY_highlightMul;
+		m_bordsLRTBDrawn = m_bordsLRTB;
 	}
 }
 
@@ -294,7 +419,7 @@ void dev::DisplayWindow::DrawDisplay()
 		}
 		}
 
-		auto framebufferTex = m_glUtils.GetFramebufferTexture(m_vramMatId);
+		auto framebufferTex = m_glUtils.GetFramebufferTexture(m_drawnMatId);
 		ImGui::Image(framebufferTex, displaySize, borderMin, borderMax);
 		m_displayIsHovered = ImGui::IsItemHovered();
 		
@@ -321,6 +446,19 @@ void dev::DisplayWindow::DrawContextMenu()
 			{
 				m_hardware.Request(Hardware::Req::SET_CPU_SPEED, { {"speed", int(m_execSpeed)} });
 			};
+			if (ImGui::Checkbox("GPU Decode", &m_gpuDecode))
+			{
+				m_hardware.Request(Hardware::Req::SET_DISPLAY_GPU_DECODE, { {"gpuDecode", m_gpuDecode} });
+			};
+			if (ImGui::Checkbox("Audio Pacing", &m_audioPacing))
+			{
+				m_hardware.Request(Hardware::Req::SET_AUDIO_PACING, { {"audioPacing", m_audioPacing} });
+			};
+			if (ImGui::Combo("Audio Rate", (int*)(&m_audioRate), m_audioRatesS))
+			{
+				int outputRate = m_audioRate == AudioRate::R44100 ? 44100 : 48000;
+				m_hardware.Request(Hardware::Req::SET_AUDIO_OUTPUT_RATE, { {"outputRate", outputRate} });
+			};
 			ImGui::EndMenu();
 		}
 		if (ImGui::BeginMenu("Help"))
@@ -38,7 +38,12 @@ namespace dev
 		const char* m_borderTypeAS[3] = { "Border: None", "Border: Normal", "Border: Full" };
 		const char* m_displaySizeAS[4] = { "Display Size: 256x256", "Display Size: 512x256", "Display Size: 512x512", "Display Size: Maximize" };
 		Hardware::ExecSpeed m_execSpeed = Hardware::ExecSpeed::NORMAL;
+		bool m_gpuDecode = false;
+		bool m_audioPacing = false;
 		const char* m_execSpeedsS = " 1%\0 20%\0 50%\0 100%\0 200%\0 MAX\0\0";
+		enum class AudioRate : int { R44100 = 0, R48000, LEN };
+		AudioRate m_audioRate = AudioRate::R48000;
+		const char* m_audioRatesS = " 44.1 KHz\0 48 KHz\0\0";
 		
 		GLUtils& m_glUtils;
 		GLUtils::Vec4 m_activeArea_pxlSize = { Display::ACTIVE_AREA_W, Display::ACTIVE_AREA_H, FRAME_PXL_SIZE_W, FRAME_PXL_SIZE_H};
@@ -52,10 +57,24 @@ namespace dev
 		dev::Id m_matParamId_scrollV_crtXY_highlightMul = -1;
 		dev::Id m_matParamId_activeArea_pxlSize = -1;
 		dev::Id m_matParamId_bordsLRTB = -1;
+		dev::Id m_matParamId_vramParams = -1;
 
 		dev::Id m_vramShaderId = -1;
 		dev::Id m_vramTexId = -1;
 		dev::Id m_vramMatId	= -1;		
+		// the gpu decode renders the frame from the screen memory copy into m_decodeMatId,
+		// m_decodedMatId draws it the same way m_vramMatId draws the rasterized frame
+		GLUtils::Vec4 m_vramParams; // scroll, border color idx, mode 512, border left
+		dev::Id m_decodeShaderId = -1;
+		dev::Id m_decodeVramTexId = -1;
+		dev::Id m_decodePaletteTexId = -1;
+		dev::Id m_decodeMatId = -1;
+		dev::Id m_decodedMatId = -1;
+		dev::Id m_drawnMatId = -1;
+		// the frame and the params drawn last time. the unchanged frame is not uploaded and drawn again
+		uint64_t m_frameContentId = UINT64_MAX;
+		GLUtils::Vec4 m_scrollV_crtXY_highlightMulDrawn;
+		GLUtils::Vec4 m_bordsLRTBDrawn;
 		bool m_isGLInited = false;
 		bool m_displayIsHovered = false;
 		const char* m_contextMenuName = "##displayCMenu";
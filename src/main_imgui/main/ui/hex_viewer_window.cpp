@@ -220,7 +220,7 @@ void dev::HexViewerWindow::DrawHex(const bool _isRunning)
 					}
 
 					if (!_isRunning) {
-						int lastRWIdx = m_debugger.GetLastRW()->at(addr + m_memPageIdx * Memory::MEM_64K);
+						int lastRWIdx = m_debugger.GetLastRW(addr + m_memPageIdx * Memory::MEM_64K);
 						auto lastReadsIdx = lastRWIdx & 0xFFFF;
 						auto lastWritesIdx = lastRWIdx >> 16;
 						
@@ -20,6 +20,56 @@ const char* memViewShaderVtx = R"(
 	}
 )";
 
+// splats the last reads and writes into the texture of the global ram layout.
+// every access is a point. the brightness is the order of the access
+const char* lastRWShaderVtx = R"(
+	#version 330 core
+	precision highp float;
+	precision highp int;
+
+	uniform usampler2D texture0; // the last reads global addrs, the least recent first
+	uniform usampler2D texture1; // the last writes global addrs, the least recent first
+
+	flat out vec4 rw; // .r - reads, .g - writes
+
+	#define LAST_RW_W 32
+	#define LAST_RW_MAX 1024
+	#define LAST_RW_NO_DATA 0xFFFFFFFFu
+	#define RAM_TEXTURE_SIZE vec2(512.0, 4224.0)
+
+	void main()
+	{
+		int idx = gl_VertexID % LAST_RW_MAX;
+		bool isWrite = gl_VertexID >= LAST_RW_MAX;
+		ivec2 idxPos = ivec2(idx % LAST_RW_W, idx / LAST_RW_W);
+
+		uint globalAddr = isWrite ? texelFetch(texture1, idxPos, 0).r : texelFetch(texture0, idxPos, 0).r;
+
+		float order = float(idx) / float(LAST_RW_MAX);
+		rw = isWrite ? vec4(0.0, order, 0.0, 1.0) : vec4(order, 0.0, 0.0, 1.0);
+
+		// out of the clip space if there is no data
+		vec2 texelPos = vec2(globalAddr & 511u, globalAddr >> 9) + 0.5;
+		gl_Position = globalAddr == LAST_RW_NO_DATA ?
+			vec4(2.0, 2.0, 2.0, 1.0) :
+			vec4(texelPos / RAM_TEXTURE_SIZE * 2.0 - 1.0, 0.0, 1.0);
+	}
+)";
+
+const char* lastRWShaderFrag = R"(
+	#version 330 core
+	precision highp float;
+
+	flat in vec4 rw;
+
+	layout (location = 0) out vec4 out0;
+
+	void main()
+	{
+		out0 = rw;
+	}
+)";
+
 const char* memViewShaderFrag = R"(
 	#version 330 core
 	precision highp float;
@@ -28,12 +78,12 @@ const char* memViewShaderFrag = R"(
 	in vec2 uv0;
 
 	uniform sampler2D texture0; // global ram values
-	uniform sampler2D texture1; // .xy - highlight reads, .zw - highlight writes
+	uniform sampler2D texture1; // .r - highlight reads, .g - highlight writes
+	uniform vec4 ramPage; // .x - the ram page idx
 	uniform vec4 globalColorBg;
 	uniform vec4 globalColorFg;
 	uniform vec4 highlightRead;
 	uniform vec4 highlightWrite;
-	uniform vec4 highlightIdxMax;
 
 	layout (location = 0) out vec4 out0;
 
@@ -48,7 +98,13 @@ const char* memViewShaderFrag = R"(
 	{
 		float isAddrBelow32K = 1.0 - step(0.5, uv0.y);
 		vec2 uv = vec2( uv0.y * 2.0, uv0.x / 2.0 + isAddrBelow32K * 0.5);
-		float byte = texture(texture0, uv).r;
+
+		// the textures store the whole global ram, RAM_TEXTURE_W bytes per row
+		ivec2 pageXY = min(ivec2(fract(uv) * 256.0), ivec2(255));
+		int globalAddr = int(ramPage.x) * 65536 + pageXY.y * 256 + pageXY.x;
+		ivec2 texelPos = ivec2(globalAddr & 511, globalAddr >> 9);
+
+		float byte = texelFetch(texture0, texelPos, 0).r;
 
 		float isOdd8K = step(0.5, fract(uv0.x / 0.5));
 		isOdd8K = mix(isOdd8K, 1.0 - isOdd8K, isAddrBelow32K);
@@ -64,9 +120,9 @@ const char* memViewShaderFrag = R"(
 		vec3 color = mix(bgColor, byteColor, float(isBitOn));
 
 		// highlight
-		vec4 rw = texture(texture1, uv);
-		float reads = (rw[1] * 256.0f + rw[0]) * 256.0f / highlightIdxMax.x;
-		float writes = (rw[3] * 255.0f + rw[2] ) * 256.0f / highlightIdxMax.x;
+		vec4 rw = texelFetch(texture1, texelPos, 0);
+		float reads = rw.r;
+		float writes = rw.g;
 		vec3 readsColor = reads * highlightRead.rgb * highlightRead.a;
 		vec3 writesColor = writes * highlightWrite.rgb * highlightWrite.a;
 		vec3 rwColor = readsColor + writesColor;
@@ -97,29 +153,42 @@ bool dev::MemDisplayWindow::Init()
 	if (memViewShaderId == INVALID_ID) return false;
 	m_memViewShaderId = memViewShaderId;
 
-	for (int i = 0; i < RAM_TEXTURES; i++){
-		// ram
-		auto memViewTexId = m_glUtils.InitTexture(RAM_TEXTURE_W, RAM_TEXTURE_H, GLUtils::Texture::Format::R8);
-		if (memViewTexId == INVALID_ID) return false;
-		m_memViewTexIds[i] = memViewTexId;
-		// highlight reads + writes
-		auto lastRWTexId = m_glUtils.InitTexture(RAM_TEXTURE_W, RAM_TEXTURE_H, GLUtils::Texture::Format::RGBA);
-		if (lastRWTexId == INVALID_ID) return false;
-		m_lastRWTexIds[i] = lastRWTexId;
-	}
+	auto lastRWShaderId = m_glUtils.InitShader(lastRWShaderVtx, lastRWShaderFrag);
+	if (lastRWShaderId == INVALID_ID) return false;
+	m_lastRWShaderId = lastRWShaderId;
+
+	// ram
+	auto memViewTexId = m_glUtils.InitTexture(RAM_TEXTURE_W, RAM_TEXTURE_H, GLUtils::Texture::Format::R8);
+	if (memViewTexId == INVALID_ID) return false;
+	m_memViewTexId = memViewTexId;
+	// the last reads + writes global addrs
+	auto lastReadsTexId = m_glUtils.InitTexture(Debugger::LAST_RW_W, Debugger::LAST_RW_H, GLUtils::Texture::Format::R32);
+	if (lastReadsTexId == INVALID_ID) return false;
+	m_lastReadsTexId = lastReadsTexId;
+	auto lastWritesTexId = m_glUtils.InitTexture(Debugger::LAST_RW_W, Debugger::LAST_RW_H, GLUtils::Texture::Format::R32);
+	if (lastWritesTexId == INVALID_ID) return false;
+	m_lastWritesTexId = lastWritesTexId;
+
+	// highlight reads + writes splatted in the ram layout
+	auto lastRWMatId = m_glUtils.InitMaterial(m_lastRWShaderId,
+		{ m_lastReadsTexId, m_lastWritesTexId }, {},
+		RAM_TEXTURE_W, RAM_TEXTURE_H);
+	if (lastRWMatId == INVALID_ID) return false;
+	m_lastRWMatId = lastRWMatId;
+	m_glUtils.SetMaterialPoints(m_lastRWMatId, Debugger::LAST_RW_MAX * 2);
 
 	GLUtils::ShaderParams memViewShaderParams = {
 		{ "globalColorBg", m_globalColorBg },
 		{ "globalColorFg", m_globalColorFg },
 		{ "highlightRead", m_highlightRead },
 		{ "highlightWrite", m_highlightWrite },
-		{ "highlightIdxMax", m_highlightIdxMax },
 	};
 
-	for (int i = 0; i < RAM_TEXTURES; i++)
+	for (int i = 0; i < RAM_PAGES; i++)
 	{
+		memViewShaderParams["ramPage"] = { static_cast<float>(i), 0.0f, 0.0f, 0.0f };
 		auto matId = m_glUtils.InitMaterial(m_memViewShaderId,
-			{m_memViewTexIds[i], m_lastRWTexIds[i]}, memViewShaderParams,
+			{m_memViewTexId, m_glUtils.GetFramebufferTexture(m_lastRWMatId)}, memViewShaderParams,
 			FRAME_BUFFER_W, FRAME_BUFFER_H);
 
 		if (matId == INVALID_ID) return false;
@@ -131,7 +200,6 @@ bool dev::MemDisplayWindow::Init()
 	m_paramId_globalColorFg = m_glUtils.GetMaterialParamId(m_memViewMatIds[0], "globalColorFg");
 	m_paramId_highlightRead = m_glUtils.GetMaterialParamId(m_memViewMatIds[0], "highlightRead");
 	m_paramId_highlightWrite = m_glUtils.GetMaterialParamId(m_memViewMatIds[0], "highlightWrite");
-	m_paramId_highlightIdxMax = m_glUtils.GetMaterialParamId(m_memViewMatIds[0], "highlightIdxMax");
 
 	return true;
 }
@@ -248,7 +316,7 @@ void dev::MemDisplayWindow::DrawDisplay()
 		ImVec2 imageSize(FRAME_BUFFER_W * m_scale, FRAME_BUFFER_H * m_scale);
 		imageHoveredId = -1;
 
-		for (int i = 0; i < RAM_TEXTURES; i++)
+		for (int i = 0; i < RAM_PAGES; i++)
 		{
 			ImGui::SeparatorText(separatorsS[i]);
 			ImVec2 imagePos = ImGui::GetCursorScreenPos();
@@ -309,27 +377,67 @@ void dev::MemDisplayWindow::UpdateData(const bool _isRunning)
 	if (m_isGLInited)
 	{
 		auto memP = m_hardware.GetRam()->data();
+		auto ramDirtyRowsP = m_hardware.GetRamDirtyRows();
 		
 		if (ccDiff != 0) m_debugger.UpdateLastRW();
-		auto memLastRWP = m_debugger.GetLastRW()->data();
 
 		// update params
 		m_glUtils.UpdateMaterialParam(m_memViewMatIds[0], m_paramId_globalColorBg, m_globalColorBg);
 		m_glUtils.UpdateMaterialParam(m_memViewMatIds[0], m_paramId_globalColorFg, m_globalColorFg);
 		m_glUtils.UpdateMaterialParam(m_memViewMatIds[0], m_paramId_highlightRead, m_highlightRead);
 		m_glUtils.UpdateMaterialParam(m_memViewMatIds[0], m_paramId_highlightWrite, m_highlightWrite);
-		m_glUtils.UpdateMaterialParam(m_memViewMatIds[0], m_paramId_highlightIdxMax, m_highlightIdxMax);
 
-		// update vram texture
-		for (int i = 0; i < RAM_TEXTURES; i++)
+		// update the ram texture. only the rows changed since the last update are uploaded
+		if (!m_texturesInited)
+		{
+			for (auto& dirtyRow : *ramDirtyRowsP) dirtyRow.store(0, std::memory_order_relaxed);
+			m_glUtils.UpdateTexture(m_memViewTexId, memP);
+			m_texturesInited = true;
+		}
+		else {
+			UpdateTextureRows(m_memViewTexId, memP, *ramDirtyRowsP);
+		}
+
+		// splat the last reads and writes
+		m_glUtils.UpdateTexture(m_lastReadsTexId, (const uint8_t*)(m_debugger.GetLastReads()->data()));
+		m_glUtils.UpdateTexture(m_lastWritesTexId, (const uint8_t*)(m_debugger.GetLastWrites()->data()));
+		m_glUtils.Draw(m_lastRWMatId);
+
+		for (int i = 0; i < RAM_PAGES; i++)
 		{
-			m_glUtils.UpdateTexture(m_memViewTexIds[i], memP + i * Memory::MEM_64K);
-			m_glUtils.UpdateTexture(m_lastRWTexIds[i], (const uint8_t*)(memLastRWP) + i * Memory::MEM_64K * 4);
 			m_glUtils.Draw(m_memViewMatIds[i]);
 		}
 	}
 }
 
+// uploads the runs of the dirty ram rows as whole texture rows.
+// a row flag is cleared before the data is read, so a write happened meanwhile
+// marks the row dirty again and it gets uploaded on the next update
+void dev::MemDisplayWindow::UpdateTextureRows(const dev::Id _textureId, const uint8_t* _memP,
+	Memory::DirtyRows& _dirtyRows)
+{
+	int runStart = -1;
+	for (int texRow = 0; texRow <= RAM_TEXTURE_H; texRow++)
+	{
+		bool dirty = false;
+		if (texRow < RAM_TEXTURE_H)
+		{
+			for (int i = 0; i < RAM_ROWS_PER_TEXTURE_ROW; i++) {
+				dirty |= _dirtyRows[texRow * RAM_ROWS_PER_TEXTURE_ROW + i].exchange(0, std::memory_order_relaxed) != 0;
+			}
+		}
+
+		if (dirty && runStart < 0) {
+			runStart = texRow;
+		}
+		else if (!dirty && runStart >= 0)
+		{
+			m_glUtils.UpdateTexture(_textureId, _memP, 0, runStart, RAM_TEXTURE_W, texRow - runStart);
+			runStart = -1;
+		}
+	}
+}
+
 // check the keys, scale the view
 void dev::MemDisplayWindow::ScaleView()
 {
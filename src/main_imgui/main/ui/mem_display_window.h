@@ -24,9 +24,12 @@ namespace dev
 		static constexpr float SCALE_MIN = 0.3f;
 		static constexpr float SCALE_INC = 0.2f;
 
-		static constexpr int RAM_TEXTURES = Memory::MEMORY_GLOBAL_LEN / Memory::MEM_64K;
-		static constexpr int RAM_TEXTURE_W = 256;
-		static constexpr int RAM_TEXTURE_H = Memory::MEMORY_MAIN_LEN / 256;
+		static constexpr int RAM_PAGES = Memory::MEMORY_GLOBAL_LEN / Memory::MEM_64K;
+		// the whole global ram in one texture. it keeps the ram layout linear
+		// to upload the changed rows by a single call per range
+		static constexpr int RAM_TEXTURE_W = 512;
+		static constexpr int RAM_TEXTURE_H = Memory::MEMORY_GLOBAL_LEN / RAM_TEXTURE_W;
+		static constexpr int RAM_ROWS_PER_TEXTURE_ROW = RAM_TEXTURE_W / Memory::RAM_ROW_LEN;
 
 		Hardware& m_hardware;
 		Debugger& m_debugger;
@@ -40,24 +43,26 @@ namespace dev
 		GLUtils::Vec4 m_globalColorFg = { 1.0f, 1.0f, 1.0f, 1.0f };		
 		GLUtils::Vec4 m_highlightRead = { 0.078f, 0.078f, 1.0f, 0.8f };
 		GLUtils::Vec4 m_highlightWrite = { 1.0f, 0.078f, 0.078f, 0.8f };
-		GLUtils::Vec4 m_highlightIdxMax = {Debugger::LAST_RW_MAX, 0.0f, 0.0f, 0.0f};
 		dev::Id m_paramId_globalColorBg = -1;
 		dev::Id m_paramId_globalColorFg = -1;
 		dev::Id m_paramId_highlightRead = -1;
 		dev::Id m_paramId_highlightWrite = -1;
-		dev::Id m_paramId_highlightIdxMax = -1;
 
 		dev::Id m_memViewShaderId = -1;
-		dev::Id m_highlightShaderId = -1;
-		std::array<dev::Id, RAM_TEXTURES> m_memViewMatIds;
-		std::array<dev::Id, RAM_TEXTURES> m_memViewTexIds;
-		std::array<dev::Id, RAM_TEXTURES> m_lastRWTexIds;
-		Debugger::MemLastRW* m_lastRWIdxsP;
+		dev::Id m_lastRWShaderId = -1;
+		std::array<dev::Id, RAM_PAGES> m_memViewMatIds;
+		dev::Id m_memViewTexId = -1;
+		dev::Id m_lastReadsTexId = -1;
+		dev::Id m_lastWritesTexId = -1;
+		dev::Id m_lastRWMatId = -1;
+		bool m_texturesInited = false; // false forces the full upload
 		bool m_isGLInited = false;
 
 		void DrawDisplay();
 		void UpdateData(const bool _isRunning);
 		void ScaleView();
+		void UpdateTextureRows(const dev::Id _textureId, const uint8_t* _memP,
+			Memory::DirtyRows& _dirtyRows);
 		bool Init();
 
 	public:
@@ -2,6 +2,7 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include <format>
 #include <iostream>
+#include <cctype>
 
 #include "utils/args_parser.h"
 #include "utils/utils.h"
@@ -21,7 +22,8 @@ dev::ArgsParser::ArgsParser(int& _argc, char** _argv,
 			const std::string paramName = _argv[i]+1;
 			std::string value;
 
-			if (i + 1 < argc && _argv[i+1][0] != '-')
+			// a negative number is a value, not a param name
+			if (i + 1 < argc && (_argv[i+1][0] != '-' || std::isdigit((unsigned char)_argv[i+1][1])))
 			{
 				i++;
 				value = _argv[i];
@@ -0,0 +1,78 @@
+#include "utils/frame_pacer.h"
+
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+dev::FramePacer::FramePacer(const Clock::duration _framePeriod)
+	:
+	m_framePeriod(_framePeriod), m_period(_framePeriod)
+{
+	Reset();
+}
+
+// restarts the deadlines from now and clears the stats
+void dev::FramePacer::Reset()
+{
+	m_deadline = m_lastWake = Clock::now();
+	m_jitterSumUs = 0;
+	m_stats = {};
+	m_stats.sleepOvershootUs = std::chrono::duration_cast<std::chrono::microseconds>(m_sleepOvershoot).count();
+}
+
+// _speedMul scales the frame rate. it has to be > 0
+void dev::FramePacer::SetSpeed(const double _speedMul)
+{
+	m_speedMul = _speedMul;
+	m_period = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double, Clock::period>(m_framePeriod.count() / _speedMul));
+	Reset();
+}
+
+// waits for the deadline of the current frame
+void dev::FramePacer::Wait()
+{
+	m_deadline += m_period;
+	auto now = Clock::now();
+
+	if (now > m_deadline)
+	{
+		m_stats.lateFrames++;
+		if (now - m_deadline > m_period * LAG_FRAMES_MAX)
+		{
+			m_deadline = now;
+			m_stats.resyncs++;
+		}
+	}
+	else {
+		// the system sleep oversleeps. it wakes up earlier by the estimated overshoot
+		auto wakeTime = m_deadline - m_sleepOvershoot - SPIN_MIN;
+		if (now < wakeTime)
+		{
+			std::this_thread::sleep_until(wakeTime);
+
+			// the estimation rises at once and decays slowly
+			auto overshoot = Clock::now() - wakeTime;
+			m_sleepOvershoot = overshoot > m_sleepOvershoot ? overshoot :
+				m_sleepOvershoot + (overshoot - m_sleepOvershoot) / 16;
+			m_sleepOvershoot = std::clamp<Clock::duration>(m_sleepOvershoot, Clock::duration::zero(), m_period / 2);
+		}
+
+		while (Clock::now() < m_deadline) {
+			std::this_thread::yield();
+		}
+	}
+
+	auto wake = Clock::now();
+	auto frameTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(wake - m_lastWake).count();
+	auto periodUs = std::chrono::duration_cast<std::chrono::microseconds>(m_period).count();
+	int64_t jitterUs = std::abs(frameTimeUs - periodUs);
+	m_lastWake = wake;
+
+	m_stats.frames++;
+	m_jitterSumUs += jitterUs;
+	m_stats.jitterAvgUs = m_jitterSumUs / (int64_t)m_stats.frames;
+	m_stats.jitterMaxUs = std::max(m_stats.jitterMaxUs, jitterUs);
+	m_stats.driftUs = std::chrono::duration_cast<std::chrono::microseconds>(wake - m_deadline).count();
+	m_stats.sleepOvershootUs = std::chrono::duration_cast<std::chrono::microseconds>(m_sleepOvershoot).count();
+}
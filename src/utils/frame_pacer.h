@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace dev
+{
+	// paces the frames to the absolute deadlines of the steady clock. a frame that wakes up late
+	// is compensated by the next ones. it sleeps up to the estimated oversleep before the deadline,
+	// then spins the rest of the time
+	class FramePacer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Stats
+		{
+			uint64_t frames = 0;		// paced frames since the last reset
+			uint64_t lateFrames = 0;	// the frames finished after their deadline
+			uint64_t resyncs = 0;		// the times the deadline lagged too much and was restarted
+			int64_t jitterAvgUs = 0;	// the average deviation of the frame time from the frame period
+			int64_t jitterMaxUs = 0;
+			int64_t driftUs = 0;		// the last wake-up time past the deadline
+			int64_t sleepOvershootUs = 0; // the estimated oversleep of the system sleep
+		};
+
+	private:
+		// the deadline is restarted instead of rushing the frames if the emulation lags more
+		static constexpr int LAG_FRAMES_MAX = 2;
+		static constexpr Clock::duration SPIN_MIN = std::chrono::microseconds(200);
+		static constexpr Clock::duration OVERSHOOT_INIT = std::chrono::milliseconds(1);
+
+		Clock::duration m_framePeriod;	// at the 1x speed
+		Clock::duration m_period;		// at the current speed
+		double m_speedMul = 1.0;
+		Clock::time_point m_deadline;
+		Clock::time_point m_lastWake;
+		Clock::duration m_sleepOvershoot = OVERSHOOT_INIT;
+		int64_t m_jitterSumUs = 0;
+		Stats m_stats;
+
+	public:
+		FramePacer(const Clock::duration _framePeriod);
+		void Reset();
+		void SetSpeed(const double _speedMul);
+		auto GetSpeed() const -> double { return m_speedMul; };
+		void Wait();
+		auto GetStats() const -> const Stats& { return m_stats; };
+	};
+}
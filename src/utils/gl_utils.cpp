@@ -1,4 +1,5 @@
 #include <format>
+#include <cstring>
 
 #include "utils/gl_utils.h"
 #include "utils/result.h"
@@ -16,6 +17,22 @@ GLfloat vertices[] = {
     1.0f,  1.0f, 0.0f,   1.0f, 0.0f   // top-right
 };
 
+// the sync objects (GL 3.2) and the buffer storage (GL 4.4) are not provided by the GL 3.0 loader
+#define GL_MAP_PERSISTENT_BIT			0x0040
+#define GL_MAP_COHERENT_BIT				0x0080
+#define GL_SYNC_GPU_COMMANDS_COMPLETE	0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT		0x00000001
+typedef void (KHRONOS_APIENTRY* PFNGLBUFFERSTORAGEPROC_)(GLenum _target, GLsizeiptr _size, const void* _data, GLbitfield _flags);
+typedef GLsync (KHRONOS_APIENTRY* PFNGLFENCESYNCPROC_)(GLenum _condition, GLbitfield _flags);
+typedef GLenum (KHRONOS_APIENTRY* PFNGLCLIENTWAITSYNCPROC_)(GLsync _sync, GLbitfield _flags, GLuint64 _timeout);
+typedef void (KHRONOS_APIENTRY* PFNGLDELETESYNCPROC_)(GLsync _sync);
+static PFNGLBUFFERSTORAGEPROC_ glBufferStorage_ = nullptr;
+static PFNGLFENCESYNCPROC_ glFenceSync_ = nullptr;
+static PFNGLCLIENTWAITSYNCPROC_ glClientWaitSync_ = nullptr;
+static PFNGLDELETESYNCPROC_ glDeleteSync_ = nullptr;
+
+static constexpr GLuint64 FENCE_TIMEOUT = 1000000000; // 1 sec in nanoseconds
+
 // it is not initializing the Window and OpenGL 3.3 context
 // assumming ImGui and did it already
  dev::GLUtils::GLUtils(bool _init)
@@ -29,6 +46,23 @@ GLfloat vertices[] = {
 		dev::Log("Failed to initialize GLAD");
 		return;  // Exit if GLAD failed to initialize
 	}
+
+	// the persistently mapped pixel buffers require GL 4.4.
+	// otherwise the pixel buffers are orphaned on every update
+	GLint majorVersion = 0;
+	GLint minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+
+	if (majorVersion > 4 || (majorVersion == 4 && minorVersion >= 4))
+	{
+		glBufferStorage_ = (PFNGLBUFFERSTORAGEPROC_)SDL_GL_GetProcAddress("glBufferStorage");
+		glFenceSync_ = (PFNGLFENCESYNCPROC_)SDL_GL_GetProcAddress("glFenceSync");
+		glClientWaitSync_ = (PFNGLCLIENTWAITSYNCPROC_)SDL_GL_GetProcAddress("glClientWaitSync");
+		glDeleteSync_ = (PFNGLDELETESYNCPROC_)SDL_GL_GetProcAddress("glDeleteSync");
+
+		m_persistentMapping = glBufferStorage_ && glFenceSync_ && glClientWaitSync_ && glDeleteSync_;
+	}
 #else
 	m_gladInited = true;
 #endif
@@ -55,6 +89,9 @@ GLfloat vertices[] = {
 	 // Unbind the buffer and VAO
 	 glBindBuffer(GL_ARRAY_BUFFER, 0);
 	 glBindVertexArray(0);
+
+	 // the core profile requires a VAO bound to draw the points
+	 glGenVertexArrays(1, &pointsVtxArrayObj);
  }
 // OUTs:
 // material ID == 0 : FAIL
@@ -120,7 +157,20 @@ dev::GLUtils::~GLUtils()
 		glDeleteTextures(1, &material.framebufferTexture);
 	}
 
-	for (const auto& [id, texture] : m_textures){
+	for (const auto& [id, texture] : m_textures)
+	{
+		for (int i = 0; i < PIXEL_BUFFERS_LEN; i++)
+		{
+			if (texture.fences[i]) glDeleteSync_(texture.fences[i]);
+			if (texture.pixelBufferPs[i])
+			{
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, texture.pixelBuffers[i]);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			}
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		if (texture.pixelBuffers[0]) glDeleteBuffers(PIXEL_BUFFERS_LEN, texture.pixelBuffers);
+
 		glDeleteTextures(1, &id);
 	}
 	
@@ -129,6 +179,7 @@ dev::GLUtils::~GLUtils()
 	}
 
 	glDeleteVertexArrays(1, &vtxArrayObj);
+	glDeleteVertexArrays(1, &pointsVtxArrayObj);
 	glDeleteBuffers(1, &vtxBufferObj);
 }
 
@@ -162,9 +213,21 @@ auto dev::GLUtils::Draw(const Id _materialId) const
 		glBindTexture(GL_TEXTURE_2D, id);
 	}
 	
-	// Bind the VAO and draw the quad
-	glBindVertexArray(vtxArrayObj);
-	glDrawArrays(GL_TRIANGLES, 0, 6);  // 6 vertices for two triangles
+	if (material.pointsCount > 0)
+	{
+		// the overlapping points keep the max of every channel
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_MAX);
+		glBindVertexArray(pointsVtxArrayObj);
+		glDrawArrays(GL_POINTS, 0, material.pointsCount);
+		glBlendEquation(GL_FUNC_ADD);
+		glDisable(GL_BLEND);
+	}
+	else {
+		// Bind the VAO and draw the quad
+		glBindVertexArray(vtxArrayObj);
+		glDrawArrays(GL_TRIANGLES, 0, 6);  // 6 vertices for two triangles
+	}
 
 	// Unbind the framebuffer and VAO
 	glBindVertexArray(0);
@@ -203,28 +266,125 @@ auto dev::GLUtils::UpdateMaterialParam(const Id _materialId,
 	return ErrCode::NO_ERRORS;
 }
 
+// the material draws _pointsCount points instead of the quad.
+// its vertex shader has to place them using gl_VertexID
+auto dev::GLUtils::SetMaterialPoints(const Id _materialId, const GLsizei _pointsCount)
+-> ErrCode
+{
+	if (!m_gladInited || !IsMaterialReady(_materialId)) return ErrCode::UNSPECIFIED;
+
+	m_materials.at(_materialId).pointsCount = _pointsCount;
+
+	return ErrCode::NO_ERRORS;
+}
+
 void dev::GLUtils::UpdateTexture(const Id _texureId, const uint8_t* _memP)
 {
-	if (_texureId == INVALID_ID) return;
+	auto it = m_textures.find(_texureId);
+	if (it == m_textures.end()) return;
+
+	UpdateTexture(_texureId, _memP, 0, 0, it->second.w, it->second.h);
+}
+
+// updates the rectangle of the texture. _memP points to the data of the whole texture.
+// the rectangle is copied into the next pixel buffer and the gpu uploads it into the texture
+// without stalling the cpu. the cpu waits only if the gpu still reads that pixel buffer
+void dev::GLUtils::UpdateTexture(const Id _texureId, const uint8_t* _memP,
+	const GLint _x, const GLint _y, const GLsizei _w, const GLsizei _h)
+{
+	if (_texureId == INVALID_ID || _w <= 0 || _h <= 0) return;
 
 	auto it = m_textures.find(_texureId);
 	if (it == m_textures.end()) return;
 
 	auto& texture = it->second;
 
-	glBindTexture(GL_TEXTURE_2D, texture.id);
+	if (!texture.pixelBuffers[0]) InitPixelBuffers(texture);
 
-	// Setup filtering parameters for display
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.filter);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.filter);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	int bufferIdx = texture.pixelBufferIdx;
+	texture.pixelBufferIdx = (bufferIdx + 1) % PIXEL_BUFFERS_LEN;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, texture.pixelBuffers[bufferIdx]);
 
-	// Upload pixels into texture
+	size_t rowSize = (size_t)_w * texture.pxlSize;
+	size_t dataSize = rowSize * _h;
+	uint8_t* bufferP = nullptr;
+
+	if (m_persistentMapping)
+	{
+		auto& fence = texture.fences[bufferIdx];
+		if (fence)
+		{
+			glClientWaitSync_(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+			glDeleteSync_(fence);
+			fence = nullptr;
+		}
+		bufferP = (uint8_t*)texture.pixelBufferPs[bufferIdx];
+	}
+	else {
+		// orphans the buffer the gpu can still read from
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, (size_t)texture.w * texture.h * texture.pxlSize, nullptr, GL_STREAM_DRAW);
+		bufferP = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, dataSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+
+	if (bufferP)
+	{
+		const uint8_t* rowP = _memP + ((size_t)_y * texture.w + _x) * texture.pxlSize;
+		if (_x == 0 && _w == texture.w)
+		{
+			std::memcpy(bufferP, rowP, dataSize);
+		}
+		else {
+			for (int row = 0; row < _h; row++)
+			{
+				std::memcpy(bufferP + row * rowSize, rowP, rowSize);
+				rowP += (size_t)texture.w * texture.pxlSize;
+			}
+		}
+
+		if (!m_persistentMapping) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		// Upload pixels into texture
+		glBindTexture(GL_TEXTURE_2D, texture.id);
 #if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 #endif
-	glTexImage2D(GL_TEXTURE_2D, 0, texture.internalFormat, texture.w, texture.h, 0, texture.internalFormat, texture.type, _memP);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _w, _h, texture.pixelFormat, texture.type, nullptr);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		if (m_persistentMapping) {
+			texture.fences[bufferIdx] = glFenceSync_(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+// creates the pixel buffers of the size of the texture
+void dev::GLUtils::InitPixelBuffers(Texture& _texture)
+{
+	size_t size = (size_t)_texture.w * _texture.h * _texture.pxlSize;
+
+	glGenBuffers(PIXEL_BUFFERS_LEN, _texture.pixelBuffers);
+
+	for (int i = 0; i < PIXEL_BUFFERS_LEN; i++)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _texture.pixelBuffers[i]);
+
+		if (m_persistentMapping)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage_(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+			_texture.pixelBufferPs[i] = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+		}
+		else {
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
 
 auto dev::GLUtils::GetFramebufferTexture(const Id _materialId) const
@@ -294,29 +454,43 @@ bool dev::GLUtils::IsMaterialReady(const Id _materialId) const
 }
 
 dev::GLUtils::Texture::Texture(GLsizei _w, GLsizei _h, Format _format, GLint _filter) 
-	: format(_format), w(_w), h(_h), filter(_filter), internalFormat(GL_RGB), type(GL_UNSIGNED_BYTE)
+	: format(_format), w(_w), h(_h), filter(_filter), internalFormat(GL_RGB), pixelFormat(GL_RGB),
+	type(GL_UNSIGNED_BYTE), pxlSize(3)
 {
 	switch (_format)
 	{
 	case Format::RGB:
-		internalFormat = GL_RGB;
+		internalFormat = pixelFormat = GL_RGB;
 		type = GL_UNSIGNED_BYTE;
+		pxlSize = 3;
 		break;
 	case Format::RGBA:
-		internalFormat = GL_RGBA;
+		internalFormat = pixelFormat = GL_RGBA;
 		type = GL_UNSIGNED_BYTE;
+		pxlSize = 4;
 		break;
 	case Format::R8:
-		internalFormat = GL_RED;
+		internalFormat = pixelFormat = GL_RED;
 		type = GL_UNSIGNED_BYTE;
+		pxlSize = 1;
 		break;
 	case Format::R32:
 		internalFormat = GL_R32UI;
+		pixelFormat = GL_RED_INTEGER;
 		type = GL_UNSIGNED_INT;
+		pxlSize = 4;
 		break;
 	}
 
 	glGenTextures(1, &id);
+
+	// allocates the texture storage once, the updates replace its data
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, pixelFormat, type, nullptr);
 }
 
 auto dev::GLUtils::InitTexture(GLsizei _w, GLsizei _h, Texture::Format _format, 
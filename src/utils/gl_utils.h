@@ -22,6 +22,7 @@ namespace dev
 			float x, y, z, w; 
 			Vec4() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {};	
 			Vec4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {};
+			bool operator==(const Vec4&) const = default;
 		};
 
 		using ShaderParamIds = std::unordered_map <std::string, dev::Id>;
@@ -30,6 +31,9 @@ namespace dev
 		using ShaderTextureParams = std::unordered_map<GLenum, dev::Id>;
 		using TextureIds = std::vector<dev::Id>;
 
+		// the amount of pixel buffers a texture streams its updates through
+		static constexpr int PIXEL_BUFFERS_LEN = 3;
+
 		struct Texture
 		{
 			enum class Format { RGB, RGBA, R8, R32, };
@@ -37,8 +41,17 @@ namespace dev
 			GLsizei w, h;
 			GLuint id;
 			GLint internalFormat;
+			GLenum pixelFormat;
 			GLenum type;
 			GLint filter;
+			int pxlSize; // in bytes
+
+			// the updates are copied into the pixel buffers in turn. the texture is updated from them
+			// asynchronously. the buffers are created with the first update
+			GLuint pixelBuffers[PIXEL_BUFFERS_LEN] = {};
+			void* pixelBufferPs[PIXEL_BUFFERS_LEN] = {}; // persistently mapped memory
+			GLsync fences[PIXEL_BUFFERS_LEN] = {}; // signaled when the gpu is done with the buffer
+			int pixelBufferIdx = 0;
 
 			Texture(GLsizei _w, GLsizei _h, Texture::Format _format, GLint _filter);
 		};
@@ -55,6 +68,7 @@ namespace dev
 			ShaderParamData params;
 			ShaderParamIds paramIds;
 			ShaderTextureParams textureParams;
+			GLsizei pointsCount = 0; // if > 0, it draws the points instead of the quad
 
 			Material(Id _shaderId, 
 				const ShaderParams& _shaderParams,
@@ -71,12 +85,15 @@ namespace dev
 		std::unordered_map<Id, Material> m_materials;
 		GLuint vtxArrayObj = 0;
 		GLuint vtxBufferObj = 0;
+		GLuint pointsVtxArrayObj = 0; // no vertex attributes, the points are placed by gl_VertexID
 		std::unordered_map<GLuint, Texture> m_textures;
 		std::vector<Id> m_shaders;
 
 		GLenum m_gladInited = 0;
+		bool m_persistentMapping = false; // GL 4.4 buffer storage is supported
 
 		void InitGeometry();
+		void InitPixelBuffers(Texture& _texture);
 		auto CompileShader(GLenum _shaderType, const char* _source) -> Id;
 		auto GLCheckError(Id _id, const std::string& _txt) -> Id;
 
@@ -101,8 +118,11 @@ namespace dev
 		auto GetMaterialParamId(const Id _materialId, const std::string& _paramName) -> Id;
 		auto UpdateMaterialParam(const Id _materialId, const Id _paramId, const Vec4& _param) 
 			-> ErrCode;
+		auto SetMaterialPoints(const Id _materialId, const GLsizei _pointsCount) -> ErrCode;
 		
 		void UpdateTexture(const Id _texureId, const uint8_t* _memP);
+		void UpdateTexture(const Id _texureId, const uint8_t* _memP,
+			const GLint _x, const GLint _y, const GLsizei _w, const GLsizei _h);
 		auto GetFramebufferTexture(const Id _materialId) const -> Id;
 		auto GetMaterial(const Id _matId) -> Material*;
 		auto GetVtxArrayObj() const -> Id { return vtxArrayObj; };
@@ -172,7 +172,7 @@ auto dev::GetExecutableDir()
     ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer)-1);
     if (len != -1) {
         buffer[len] = '\0';
-        path = dev::string(buffer);
+        path = std::string(buffer);
     }
 #endif
 	return dev::GetDir(path) + "/";